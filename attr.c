@@ -136,11 +136,12 @@ struct all_attrs_item {
 /*
  * Reallocate and reinitialize the array of all attributes (which is used in
  * the attribute collection process) in 'check' based on the global dictionary
- * of attributes.
+ * of attributes. The 'macro' fields are left alone; 1 is returned if the
+ * array had to be reallocated, in which case the caller must reset them.
  */
-static void all_attrs_init(struct attr_hashmap *map, struct attr_check *check)
+static int all_attrs_init(struct attr_hashmap *map, struct attr_check *check)
 {
-	int i;
+	int i, resized = 0;
 	unsigned int size;
 
 	hashmap_lock(map);
@@ -167,6 +168,7 @@ static void all_attrs_init(struct attr_hashmap *map, struct attr_check *check)
 			const struct git_attr *a = e->value;
 			check->all_attrs[a->attr_nr].attr = a;
 		}
+		resized = 1;
 	}
 
 	hashmap_unlock(map);
@@ -176,10 +178,9 @@ static void all_attrs_init(struct attr_hashmap *map, struct attr_check *check)
 	 * This re-initialization can live outside of the locked region since
 	 * the attribute dictionary is no longer being accessed.
 	 */
-	for (i = 0; i < check->all_attrs_nr; i++) {
+	for (i = 0; i < check->all_attrs_nr; i++)
 		check->all_attrs[i].value = ATTR__UNKNOWN;
-		check->all_attrs[i].macro = NULL;
-	}
+	return resized;
 }
 
 static int attr_name_valid(const char *name, size_t namelen)
@@ -947,13 +948,18 @@ static void bootstrap_attr_stack(struct index_state *istate,
 	push_stack(stack, e, NULL, 0);
 }
 
-static void prepare_attr_stack(struct index_state *istate,
-			       const struct object_id *tree_oid,
-			       const char *path, int dirlen,
-			       struct attr_stack **stack)
+/*
+ * Returns 1 if any frame of the stack was (re)built, or 0 if it is
+ * exactly the stack the previous lookup through it used.
+ */
+static int prepare_attr_stack(struct index_state *istate,
+			      const struct object_id *tree_oid,
+			      const char *path, int dirlen,
+			      struct attr_stack **stack)
 {
 	struct attr_stack *info;
 	struct strbuf pathbuf = STRBUF_INIT;
+	int changed = !*stack;
 
 	/*
 	 * At the bottom of the attribute stack is the built-in
@@ -996,6 +1002,7 @@ static void prepare_attr_stack(struct index_state *istate,
 
 		*stack = elem->prev;
 		attr_stack_free(elem);
+		changed = 1;
 	}
 
 	/*
@@ -1032,6 +1039,8 @@ static void prepare_attr_stack(struct index_state *istate,
 
 		origin = xstrdup(pathbuf.buf);
 		push_stack(stack, next, origin, len);
+		if (next)
+			changed = 1;
 	}
 
 	/*
@@ -1040,6 +1049,7 @@ static void prepare_attr_stack(struct index_state *istate,
 	push_stack(stack, info, NULL, 0);
 
 	strbuf_release(&pathbuf);
+	return changed;
 }
 
 static int path_matches(const char *pathname, int pathlen,
@@ -1151,6 +1161,7 @@ static void collect_some_attrs(struct index_state *istate,
 	int pathlen, rem, dirlen;
 	const char *cp, *last_slash = NULL;
 	int basename_offset;
+	int stack_changed;
 
 	for (cp = path; *cp; cp++) {
 		if (*cp == '/' && cp[1])
@@ -1165,9 +1176,20 @@ static void collect_some_attrs(struct index_state *istate,
 		dirlen = 0;
 	}
 
-	prepare_attr_stack(istate, tree_oid, path, dirlen, &check->stack);
-	all_attrs_init(&g_attr_hashmap, check);
-	determine_macros(check->all_attrs, check->stack);
+	/*
+	 * The macros only depend on the stack, so there is no need to
+	 * look for them again as long as it stays the same, as it does
+	 * for consecutive paths in the same directory.
+	 */
+	stack_changed = prepare_attr_stack(istate, tree_oid, path, dirlen,
+					   &check->stack);
+	if (all_attrs_init(&g_attr_hashmap, check) || stack_changed) {
+		int i;
+
+		for (i = 0; i < check->all_attrs_nr; i++)
+			check->all_attrs[i].macro = NULL;
+		determine_macros(check->all_attrs, check->stack);
+	}
 
 	rem = check->all_attrs_nr;
 	fill(path, pathlen, basename_offset, check->stack, check->all_attrs, rem);
@@ -6,18 +6,28 @@
 #include "convert.h"
 #include "diff.h"
 #include "diffcore.h"
+#include "dir.h"
 #include "gettext.h"
 #include "hex.h"
+#include "list.h"
 #include "path.h"
 #include "read-cache.h"
+#include "replace-object.h"
 #include "setup.h"
+#include "shallow.h"
 #include "tag.h"
+#include "thread-utils.h"
 #include "trace2.h"
 #include "blame.h"
 #include "alloc.h"
 #include "commit-slab.h"
 #include "bloom.h"
 #include "commit-graph.h"
+#include "lockfile.h"
+#include "object-file.h"
+#include "quote.h"
+#include "userdiff.h"
+#include "wrapper.h"
 
 define_commit_slab(blame_suspects, struct blame_origin *);
 static struct blame_suspects blame_suspects;
@@ -1018,6 +1028,30 @@ static void drop_origin_fingerprints(struct blame_origin *o)
 	}
 }
 
+static void read_origin_blob(struct diff_options *opt,
+			     struct blame_origin *o, mmfile_t *file,
+			     int *num_read_blob)
+{
+	enum object_type type;
+	unsigned long file_size;
+
+	(*num_read_blob)++;
+	if (opt->flags.allow_textconv &&
+	    textconv_object(opt->repo, o->path, o->mode,
+			    &o->blob_oid, 1, &file->ptr, &file_size))
+		;
+	else
+		file->ptr = repo_read_object_file(the_repository,
+						  &o->blob_oid, &type,
+						  &file_size);
+	file->size = file_size;
+
+	if (!file->ptr)
+		die("Cannot read blob %s for path %s",
+		    oid_to_hex(&o->blob_oid),
+		    o->path);
+}
+
 /*
  * Given an origin, prepare mmfile_t structure to be used by the
  * diff machinery
@@ -1027,24 +1061,7 @@ static void fill_origin_blob(struct diff_options *opt,
 			     int *num_read_blob, int fill_fingerprints)
 {
 	if (!o->file.ptr) {
-		enum object_type type;
-		unsigned long file_size;
-
-		(*num_read_blob)++;
-		if (opt->flags.allow_textconv &&
-		    textconv_object(opt->repo, o->path, o->mode,
-				    &o->blob_oid, 1, &file->ptr, &file_size))
-			;
-		else
-			file->ptr = repo_read_object_file(the_repository,
-							  &o->blob_oid, &type,
-							  &file_size);
-		file->size = file_size;
-
-		if (!file->ptr)
-			die("Cannot read blob %s for path %s",
-			    oid_to_hex(&o->blob_oid),
-			    o->path);
+		read_origin_blob(opt, o, file, num_read_blob);
 		o->file = *file;
 	}
 	else
@@ -1927,6 +1944,195 @@ static int blame_chunk_cb(long start_a, long count_a,
 	return 0;
 }
 
+/*
+ * With more than one thread, the diffs between a suspect and its parent
+ * are computed ahead of time on worker threads, for the suspect about to
+ * be processed and for the commits found by following the history of
+ * the path down from it.  Finding the parents' origins and reading
+ * their blobs stays on the main thread, as does everything that touches
+ * the scoreboard; the workers only turn two buffers into a list of
+ * hunks, which pass_blame_to_parent() replays in the same order the
+ * diff machinery would have produced them.
+ */
+struct blame_hunk {
+	long start_a, count_a;
+	long start_b, count_b;
+};
+
+enum blame_diff_state {
+	BLAME_DIFF_QUEUED,
+	BLAME_DIFF_RUNNING,
+	BLAME_DIFF_DONE,
+};
+
+struct blame_diff_job {
+	struct list_head lru;
+	struct list_head work;
+	struct blame_origin *target;
+	struct blame_origin *parent;
+	int same; /* same blob in parent, nothing to diff */
+	enum blame_diff_state state; /* protected by the mutex */
+	mmfile_t file_p, file_o;
+	struct blame_hunk *hunks;
+	int nr, alloc;
+	int ret;
+};
+
+struct blame_diff_queue {
+	pthread_mutex_t mutex;
+	pthread_cond_t work_cond;
+	pthread_cond_t done_cond;
+	pthread_t *threads;
+	int nr_threads;
+	int stop;
+	int xdl_opts;
+
+	/* jobs, most recently used first; only used by the main thread */
+	struct list_head jobs;
+	int nr_jobs;
+	/* jobs waiting for a worker, protected by the mutex */
+	struct list_head work;
+
+	/* the blob most recently read as a parent, see read_diff_blob() */
+	mmfile_t last;
+	struct object_id last_oid;
+	char *last_path;
+
+	/* stats */
+	int nr_queued;
+	int nr_used;
+};
+
+static int record_hunk(long start_a, long count_a,
+		       long start_b, long count_b, void *data)
+{
+	struct blame_diff_job *job = data;
+	struct blame_hunk *h;
+
+	ALLOC_GROW(job->hunks, job->nr + 1, job->alloc);
+	h = &job->hunks[job->nr++];
+	h->start_a = start_a;
+	h->count_a = count_a;
+	h->start_b = start_b;
+	h->count_b = count_b;
+	return 0;
+}
+
+static void run_blame_diff(struct blame_diff_job *job, int xdl_opts)
+{
+	job->ret = diff_hunks(&job->file_p, &job->file_o,
+			      record_hunk, job, xdl_opts);
+	FREE_AND_NULL(job->file_p.ptr);
+	FREE_AND_NULL(job->file_o.ptr);
+}
+
+static void *blame_diff_thread(void *data)
+{
+	struct blame_diff_queue *q = data;
+
+	trace2_thread_start("blame_diff");
+	pthread_mutex_lock(&q->mutex);
+	for (;;) {
+		struct blame_diff_job *job;
+
+		while (!q->stop && list_empty(&q->work))
+			pthread_cond_wait(&q->work_cond, &q->mutex);
+		if (q->stop)
+			break;
+		job = list_first_entry(&q->work, struct blame_diff_job, work);
+		list_del_init(&job->work);
+		job->state = BLAME_DIFF_RUNNING;
+		pthread_mutex_unlock(&q->mutex);
+
+		run_blame_diff(job, q->xdl_opts);
+
+		pthread_mutex_lock(&q->mutex);
+		job->state = BLAME_DIFF_DONE;
+		pthread_cond_broadcast(&q->done_cond);
+	}
+	pthread_mutex_unlock(&q->mutex);
+	trace2_thread_exit();
+	return NULL;
+}
+
+/*
+ * Make sure the job is finished.  One that no worker has picked up yet
+ * is run right here instead of waiting for a worker to get to it.
+ */
+static void finish_blame_diff(struct blame_diff_queue *q,
+			      struct blame_diff_job *job)
+{
+	pthread_mutex_lock(&q->mutex);
+	if (job->state == BLAME_DIFF_QUEUED) {
+		list_del_init(&job->work);
+		job->state = BLAME_DIFF_RUNNING;
+		pthread_mutex_unlock(&q->mutex);
+		run_blame_diff(job, q->xdl_opts);
+		pthread_mutex_lock(&q->mutex);
+		job->state = BLAME_DIFF_DONE;
+	}
+	while (job->state == BLAME_DIFF_RUNNING)
+		pthread_cond_wait(&q->done_cond, &q->mutex);
+	pthread_mutex_unlock(&q->mutex);
+}
+
+static struct blame_diff_job *find_blame_diff(struct blame_diff_queue *q,
+					      struct blame_origin *target)
+{
+	struct list_head *pos;
+
+	list_for_each(pos, &q->jobs) {
+		struct blame_diff_job *job =
+			list_entry(pos, struct blame_diff_job, lru);
+		if (job->target == target) {
+			list_move(&job->lru, &q->jobs);
+			return job;
+		}
+	}
+	return NULL;
+}
+
+static void free_blame_diff(struct blame_diff_queue *q,
+			    struct blame_diff_job *job)
+{
+	pthread_mutex_lock(&q->mutex);
+	if (job->state == BLAME_DIFF_QUEUED)
+		list_del(&job->work);
+	while (job->state == BLAME_DIFF_RUNNING)
+		pthread_cond_wait(&q->done_cond, &q->mutex);
+	pthread_mutex_unlock(&q->mutex);
+
+	list_del(&job->lru);
+	q->nr_jobs--;
+	blame_origin_decref(job->target);
+	blame_origin_decref(job->parent);
+	free(job->file_p.ptr);
+	free(job->file_o.ptr);
+	free(job->hunks);
+	free(job);
+}
+
+/*
+ * Return the hunks between parent and target if they have been
+ * computed (or are being computed) ahead of time.
+ */
+static struct blame_diff_job *get_blame_diff(struct blame_scoreboard *sb,
+					     struct blame_origin *target,
+					     struct blame_origin *parent)
+{
+	struct blame_diff_queue *q = sb->diff_queue;
+	struct blame_diff_job *job;
+
+	if (!q)
+		return NULL;
+	job = find_blame_diff(q, target);
+	if (!job || job->parent != parent || job->same)
+		return NULL;
+	finish_blame_diff(q, job);
+	q->nr_used++;
+	return job;
+}
+
 /*
  * We are looking at the origin 'target' and aiming to pass blame
  * for the lines it is suspected to its parent.  Run diff to find
@@ -1939,6 +2145,8 @@ static void pass_blame_to_parent(struct blame_scoreboard *sb,
 	mmfile_t file_p, file_o;
 	struct blame_chunk_cb_data d;
 	struct blame_entry *newdest = NULL;
+	struct blame_diff_job *job;
+	int i, ret;
 
 	if (!target->suspects)
 		return; /* nothing remains for this target */
@@ -1949,13 +2157,24 @@ static void pass_blame_to_parent(struct blame_scoreboard *sb,
 	d.ignore_diffs = ignore_diffs;
 	d.dstq = &newdest; d.srcq = &target->suspects;
 
-	fill_origin_blob(&sb->revs->diffopt, parent, &file_p,
-			 &sb->num_read_blob, ignore_diffs);
-	fill_origin_blob(&sb->revs->diffopt, target, &file_o,
-			 &sb->num_read_blob, ignore_diffs);
+	job = get_blame_diff(sb, target, parent);
+	if (!job || ignore_diffs) {
+		fill_origin_blob(&sb->revs->diffopt, parent, &file_p,
+				 &sb->num_read_blob, ignore_diffs);
+		fill_origin_blob(&sb->revs->diffopt, target, &file_o,
+				 &sb->num_read_blob, ignore_diffs);
+	}
 	sb->num_get_patch++;
 
-	if (diff_hunks(&file_p, &file_o, blame_chunk_cb, &d, sb->xdl_opts))
+	if (job) {
+		for (i = 0; i < job->nr; i++)
+			blame_chunk_cb(job->hunks[i].start_a, job->hunks[i].count_a,
+				       job->hunks[i].start_b, job->hunks[i].count_b,
+				       &d);
+		ret = job->ret;
+	} else
+		ret = diff_hunks(&file_p, &file_o, blame_chunk_cb, &d, sb->xdl_opts);
+	if (ret)
 		die("unable to generate diff (%s -> %s)",
 		    oid_to_hex(&parent->commit->object.oid),
 		    oid_to_hex(&target->commit->object.oid));
@@ -2376,6 +2595,192 @@ static int num_scapegoats(struct rev_info *revs, struct commit *commit, int reve
 	return commit_list_count(l);
 }
 
+/* how far down the history prefetch_blame_diffs() looks */
+#define BLAME_DIFF_MAX_WALK 32
+
+/*
+ * Read the contents of "o" into a buffer of its own for a worker.  The
+ * blob last read as a parent is kept, as it is usually the target of
+ * the next diff down the history.
+ */
+static void read_diff_blob(struct blame_scoreboard *sb,
+			   struct blame_origin *o, mmfile_t *file)
+{
+	struct blame_diff_queue *q = sb->diff_queue;
+
+	if (q->last.ptr && oideq(&q->last_oid, &o->blob_oid) &&
+	    !strcmp(q->last_path, o->path)) {
+		*file = q->last;
+		q->last.ptr = NULL;
+	} else if (o->file.ptr) {
+		file->ptr = xmemdupz(o->file.ptr, o->file.size);
+		file->size = o->file.size;
+	} else
+		read_origin_blob(&sb->revs->diffopt, o, file,
+				 &sb->num_read_blob);
+}
+
+/*
+ * Find the origin in the only parent of the origin's commit, and queue
+ * the diff between the two for the workers unless the blob is the same.
+ */
+static struct blame_diff_job *queue_blame_diff(struct blame_scoreboard *sb,
+					       struct blame_origin *origin)
+{
+	struct blame_diff_queue *q = sb->diff_queue;
+	struct rev_info *revs = sb->revs;
+	struct commit *commit = origin->commit;
+	struct commit *parent;
+	struct blame_origin *porigin;
+	struct blame_diff_job *job;
+
+	/* these are the commits assign_blame() would not pass blame from */
+	if (repo_parse_commit(the_repository, commit) ||
+	    (commit->object.flags & UNINTERESTING) ||
+	    (revs->max_age != -1 && commit->date < revs->max_age) ||
+	    num_scapegoats(revs, commit, 0) != 1)
+		return NULL;
+	parent = first_scapegoat(revs, commit, 0)->item;
+	if (repo_parse_commit(the_repository, parent))
+		return NULL;
+	porigin = find_origin(sb->repo, parent, origin, sb->bloom_data);
+	if (!porigin)
+		return NULL;
+
+	while (q->nr_jobs >= 4 * BLAME_DIFF_MAX_WALK)
+		free_blame_diff(q, list_entry(q->jobs.prev,
+					      struct blame_diff_job, lru));
+
+	CALLOC_ARRAY(job, 1);
+	job->target = blame_origin_incref(origin);
+	job->parent = porigin;
+	INIT_LIST_HEAD(&job->work);
+	list_add(&job->lru, &q->jobs);
+	q->nr_jobs++;
+	if (oideq(&porigin->blob_oid, &origin->blob_oid)) {
+		job->same = 1;
+		job->state = BLAME_DIFF_DONE;
+		return job;
+	}
+
+	read_diff_blob(sb, origin, &job->file_o);
+	read_diff_blob(sb, porigin, &job->file_p);
+	free(q->last.ptr);
+	q->last.ptr = xmemdupz(job->file_p.ptr, job->file_p.size);
+	q->last.size = job->file_p.size;
+	oidcpy(&q->last_oid, &porigin->blob_oid);
+	free(q->last_path);
+	q->last_path = xstrdup(porigin->path);
+
+	pthread_mutex_lock(&q->mutex);
+	job->state = BLAME_DIFF_QUEUED;
+	list_add_tail(&job->work, &q->work);
+	pthread_cond_signal(&q->work_cond);
+	pthread_mutex_unlock(&q->mutex);
+	q->nr_queued++;
+	return job;
+}
+
+/*
+ * Make sure the diffs for the origin and the next few commits down the
+ * history of its path are on their way, so that the workers stay busy
+ * while the main thread goes through them.  Only single-parent commits
+ * are followed; at a merge, the walk starts again from each parent once
+ * it comes up as a suspect.
+ */
+static void prefetch_blame_diffs(struct blame_scoreboard *sb,
+				 struct blame_origin *origin)
+{
+	struct blame_diff_queue *q = sb->diff_queue;
+	int steps, ahead = 0;
+
+	if (!q)
+		return;
+	for (steps = 0; steps < BLAME_DIFF_MAX_WALK; steps++) {
+		struct blame_diff_job *job = find_blame_diff(q, origin);
+
+		if (!job && !(job = queue_blame_diff(sb, origin)))
+			break;
+		if (!job->same &&
+		    ++ahead >= 2 * q->nr_threads)
+			break;
+		origin = job->parent;
+	}
+}
+
+/* The origin has been dealt with; its diff is no longer needed. */
+static void drop_blame_diff(struct blame_scoreboard *sb,
+			    struct blame_origin *origin)
+{
+	struct blame_diff_job *job;
+
+	if (!sb->diff_queue)
+		return;
+	job = find_blame_diff(sb->diff_queue, origin);
+	if (job)
+		free_blame_diff(sb->diff_queue, job);
+}
+
+void setup_blame_diff_threads(struct blame_scoreboard *sb, int nr_threads)
+{
+	struct blame_diff_queue *q;
+	int i;
+
+	if (!HAVE_THREADS || nr_threads < 2 || sb->reverse)
+		return;
+
+	CALLOC_ARRAY(q, 1);
+	pthread_mutex_init(&q->mutex, NULL);
+	pthread_cond_init(&q->work_cond, NULL);
+	pthread_cond_init(&q->done_cond, NULL);
+	INIT_LIST_HEAD(&q->jobs);
+	INIT_LIST_HEAD(&q->work);
+	q->xdl_opts = sb->xdl_opts;
+
+	ALLOC_ARRAY(q->threads, nr_threads);
+	for (i = 0; i < nr_threads; i++) {
+		int err = pthread_create(&q->threads[i], NULL,
+					 blame_diff_thread, q);
+		if (err)
+			die(_("unable to create thread: %s"), strerror(err));
+	}
+	q->nr_threads = nr_threads;
+	sb->diff_queue = q;
+}
+
+static void stop_blame_diff_threads(struct blame_scoreboard *sb)
+{
+	struct blame_diff_queue *q = sb->diff_queue;
+	int i;
+
+	if (!q)
+		return;
+
+	while (!list_empty(&q->jobs))
+		free_blame_diff(q, list_first_entry(&q->jobs,
+						    struct blame_diff_job, lru));
+	pthread_mutex_lock(&q->mutex);
+	q->stop = 1;
+	pthread_cond_broadcast(&q->work_cond);
+	pthread_mutex_unlock(&q->mutex);
+	for (i = 0; i < q->nr_threads; i++)
+		if (pthread_join(q->threads[i], NULL))
+			die("unable to join blame diff thread");
+
+	trace2_data_intmax("blame", sb->repo,
+			   "prefetch/diffs-queued", q->nr_queued);
+	trace2_data_intmax("blame", sb->repo,
+			   "prefetch/diffs-used", q->nr_used);
+
+	pthread_cond_destroy(&q->done_cond);
+	pthread_cond_destroy(&q->work_cond);
+	pthread_mutex_destroy(&q->mutex);
+	free(q->threads);
+	free(q->last.ptr);
+	free(q->last_path);
+	FREE_AND_NULL(sb->diff_queue);
+}
+
 /* Distribute collected unsorted blames to the respected sorted lists
  * in the various origins.
  */
@@ -2572,6 +2977,449 @@ static void pass_blame(struct blame_scoreboard *sb, struct blame_origin *origin,
 		free(sg_origin);
 }
 
+/*
+ * With "blame.cache", finished results are kept in $GIT_DIR/blame-cache,
+ * one file per commit and path, mapping the lines of that blob to the
+ * commits and paths that introduced them.  A later blame that reaches
+ * the same commit and path, e.g. one started from a descendant, then
+ * takes the remaining lines from there at once instead of digging
+ * through the rest of history again.
+ *
+ * A cache file consists of these lines, paths quoted as needed:
+ *
+ *   k <commit> <xdl-opts> <first-parent> <no-whole-file-rename> <path>
+ *   o <commit> <path>            an origin, numbered from 0
+ *   p <commit> <path>            the "previous" of the origin before it
+ *   e <lno> <num_lines> <s_lno> <origin>
+ *
+ * The "e" lines are sorted by <lno> and cover the whole blob.
+ */
+static int blame_cache_hits;
+static int blame_cache_misses;
+
+struct blame_cache_entry {
+	int lno;
+	int num_lines;
+	int s_lno;
+	struct blame_origin *origin;
+};
+
+static char *blame_cache_file(struct blame_scoreboard *sb,
+			      struct commit *commit, const char *path,
+			      struct strbuf *key)
+{
+	const struct git_hash_algo *algo = sb->repo->hash_algo;
+	unsigned char hash[GIT_MAX_RAWSZ];
+	git_hash_ctx ctx;
+	const char *hex;
+
+	strbuf_addf(key, "k %s %x %d %d ", oid_to_hex(&commit->object.oid),
+		    sb->xdl_opts, sb->revs->first_parent_only,
+		    sb->no_whole_file_rename);
+	quote_c_style(path, key, NULL, 0);
+
+	algo->init_fn(&ctx);
+	algo->update_fn(&ctx, key->buf, key->len);
+	algo->final_fn(hash, &ctx);
+	hex = hash_to_hex_algop(hash, algo);
+	return repo_git_path(sb->repo, "blame-cache/%.2s/%s", hex, hex + 2);
+}
+
+static int parse_cache_ints(const char *p, int *v, int nr)
+{
+	while (nr--) {
+		char *end;
+		long l = strtol(p, &end, 10);
+
+		if (end == p || l < 0 || l > INT_MAX || *end != (nr ? ' ' : '\0'))
+			return -1;
+		*v++ = l;
+		p = end + 1;
+	}
+	return 0;
+}
+
+static struct blame_origin *parse_cache_origin(struct blame_scoreboard *sb,
+					       const char *line)
+{
+	struct strbuf path = STRBUF_INIT;
+	struct object_id oid;
+	struct commit *commit;
+	struct blame_origin *o = NULL;
+	const char *p;
+
+	if (parse_oid_hex(line, &oid, &p) || *p++ != ' ')
+		goto out;
+	if (*p != '"')
+		strbuf_addstr(&path, p);
+	else if (unquote_c_style(&path, p, NULL))
+		goto out;
+	commit = lookup_commit(sb->repo, &oid);
+	if (!commit || repo_parse_commit(sb->repo, commit))
+		goto out;
+	/* treat root commit as boundary, as assign_blame() does */
+	if (!commit->parents && !sb->show_root)
+		commit->object.flags |= UNINTERESTING;
+	o = get_origin(commit, path.buf);
+out:
+	strbuf_release(&path);
+	return o;
+}
+
+/*
+ * Read the cached result for the suspect's commit and path.  The
+ * origins it names are returned with a reference held in *origins_p.
+ */
+static struct blame_cache_entry *read_blame_cache(struct blame_scoreboard *sb,
+						  struct blame_origin *suspect,
+						  int *nr_p,
+						  struct blame_origin ***origins_p,
+						  int *origins_nr_p)
+{
+	struct strbuf key = STRBUF_INIT, buf = STRBUF_INIT;
+	struct blame_cache_entry *entries = NULL;
+	struct blame_origin **origins = NULL;
+	int nr = 0, alloc = 0, origins_nr = 0, origins_alloc = 0;
+	char *file, *line, *eol;
+	int ok = 0;
+
+	file = blame_cache_file(sb, suspect->commit, suspect->path, &key);
+	if (strbuf_read_file(&buf, file, 0) < 0)
+		goto out;
+
+	strbuf_addch(&key, '\n');
+	if (!starts_with(buf.buf, key.buf))
+		goto out;
+	for (line = buf.buf + key.len; *line; line = eol + 1) {
+		struct blame_origin *o;
+		struct blame_cache_entry *e;
+		int v[4];
+
+		eol = strchr(line, '\n');
+		if (!eol || line[0] == '\0' || line[1] != ' ')
+			goto out;
+		*eol = '\0';
+
+		switch (line[0]) {
+		case 'o':
+			if (!(o = parse_cache_origin(sb, line + 2)))
+				goto out;
+			ALLOC_GROW(origins, origins_nr + 1, origins_alloc);
+			origins[origins_nr++] = o;
+			break;
+		case 'p':
+			if (!origins_nr || !(o = parse_cache_origin(sb, line + 2)))
+				goto out;
+			if (origins[origins_nr - 1]->previous)
+				blame_origin_decref(o);
+			else
+				origins[origins_nr - 1]->previous = o;
+			break;
+		case 'e':
+			if (parse_cache_ints(line + 2, v, 4) ||
+			    v[0] != (nr ? entries[nr - 1].lno + entries[nr - 1].num_lines : 0) ||
+			    !v[1] || v[3] >= origins_nr)
+				goto out;
+			ALLOC_GROW(entries, nr + 1, alloc);
+			e = &entries[nr++];
+			e->lno = v[0];
+			e->num_lines = v[1];
+			e->s_lno = v[2];
+			e->origin = origins[v[3]];
+			break;
+		default:
+			goto out;
+		}
+	}
+	ok = nr > 0;
+	if (ok)
+		check_and_freshen_file(file, 1); /* keep it from being pruned */
+
+out:
+	if (!ok) {
+		while (origins_nr)
+			blame_origin_decref(origins[--origins_nr]);
+		FREE_AND_NULL(origins);
+		FREE_AND_NULL(entries);
+		nr = 0;
+	}
+	*nr_p = nr;
+	*origins_p = origins;
+	*origins_nr_p = origins_nr;
+	free(file);
+	strbuf_release(&key);
+	strbuf_release(&buf);
+	return entries;
+}
+
+/*
+ * If the result for the suspect's commit and path is cached, hand
+ * each of its blame entries to the origins the cache names for those
+ * lines, and return 1.
+ */
+static int use_blame_cache(struct blame_scoreboard *sb,
+			   struct blame_origin *suspect)
+{
+	struct blame_cache_entry *entries;
+	struct blame_origin **origins;
+	struct blame_entry *e, *next;
+	int nr, origins_nr, total, ret = 0;
+
+	entries = read_blame_cache(sb, suspect, &nr, &origins, &origins_nr);
+	if (!entries)
+		goto out;
+
+	total = entries[nr - 1].lno + entries[nr - 1].num_lines;
+	for (e = suspect->suspects; e; e = e->next)
+		if (e->s_lno + e->num_lines > total)
+			goto out;
+
+	for (e = suspect->suspects; e; e = next) {
+		int start = e->s_lno, end = e->s_lno + e->num_lines;
+		int lo = 0, hi = nr;
+
+		/* find the cached entry holding the first line */
+		while (lo + 1 < hi) {
+			int mi = lo + (hi - lo) / 2;
+			if (entries[mi].lno <= start)
+				lo = mi;
+			else
+				hi = mi;
+		}
+		while (start < end) {
+			struct blame_cache_entry *c = &entries[lo++];
+			int stop = end < c->lno + c->num_lines ?
+				end : c->lno + c->num_lines;
+			struct blame_entry *n = xcalloc(1, sizeof(*n));
+
+			n->lno = e->lno + start - e->s_lno;
+			n->num_lines = stop - start;
+			n->s_lno = c->s_lno + start - c->lno;
+			n->suspect = blame_origin_incref(c->origin);
+			c->origin->guilty = 1;
+			if (sb->found_guilty_entry)
+				sb->found_guilty_entry(n, sb->found_guilty_entry_data);
+			n->next = sb->ent;
+			sb->ent = n;
+			start = stop;
+		}
+		next = e->next;
+		blame_origin_decref(e->suspect);
+		free(e);
+	}
+	suspect->suspects = NULL;
+	ret = 1;
+
+out:
+	if (ret)
+		blame_cache_hits++;
+	else
+		blame_cache_misses++;
+	while (origins_nr)
+		blame_origin_decref(origins[--origins_nr]);
+	free(origins);
+	free(entries);
+	return ret;
+}
+
+static int compare_blame_entry_lno(const void *a_, const void *b_)
+{
+	const struct blame_entry *a = *(const struct blame_entry **)a_;
+	const struct blame_entry *b = *(const struct blame_entry **)b_;
+
+	return a->lno < b->lno ? -1 : a->lno > b->lno;
+}
+
+static int compare_origin_ptr(const void *a_, const void *b_)
+{
+	uintptr_t a = (uintptr_t)*(struct blame_origin **)a_;
+	uintptr_t b = (uintptr_t)*(struct blame_origin **)b_;
+
+	return a < b ? -1 : a > b;
+}
+
+static void write_cache_origin(struct strbuf *buf, char type,
+			       struct blame_origin *o)
+{
+	strbuf_addf(buf, "%c %s ", type, oid_to_hex(&o->commit->object.oid));
+	quote_c_style(o->path, buf, NULL, 0);
+	strbuf_addch(buf, '\n');
+}
+
+static void write_blame_cache(struct blame_scoreboard *sb)
+{
+	struct strbuf key = STRBUF_INIT, buf = STRBUF_INIT;
+	struct lock_file lk = LOCK_INIT;
+	struct blame_entry **ents = NULL, *e;
+	struct blame_origin **origins = NULL;
+	int i, nr = 0, origins_nr = 0, total = 0;
+	char *file = NULL;
+
+	if (is_null_oid(&sb->final->object.oid))
+		return;
+	for (e = sb->ent; e; e = e->next) {
+		nr++;
+		total += e->num_lines;
+	}
+	if (!nr || total != sb->num_lines)
+		return; /* only part of the file was blamed */
+
+	file = blame_cache_file(sb, sb->final, sb->path, &key);
+	if (file_exists(file))
+		goto out;
+
+	ALLOC_ARRAY(ents, nr);
+	ALLOC_ARRAY(origins, nr);
+	for (i = 0, e = sb->ent; e; e = e->next, i++) {
+		ents[i] = e;
+		origins[i] = e->suspect;
+	}
+	QSORT(ents, nr, compare_blame_entry_lno);
+	QSORT(origins, nr, compare_origin_ptr);
+	for (i = 0; i < nr; i++)
+		if (!origins_nr || origins[origins_nr - 1] != origins[i])
+			origins[origins_nr++] = origins[i];
+	for (i = 0; i < origins_nr; i++) {
+		struct commit *commit = origins[i]->commit;
+
+		/* a shallow boundary is not where the history really ends */
+		if (!commit->parents &&
+		    lookup_commit_graft(sb->repo, &commit->object.oid))
+			goto out;
+	}
+
+	strbuf_addbuf(&buf, &key);
+	strbuf_addch(&buf, '\n');
+	for (i = 0; i < origins_nr; i++) {
+		write_cache_origin(&buf, 'o', origins[i]);
+		if (origins[i]->previous)
+			write_cache_origin(&buf, 'p', origins[i]->previous);
+	}
+	for (i = 0; i < nr; i++) {
+		struct blame_origin **o;
+		int lno = ents[i]->lno, num_lines = ents[i]->num_lines;
+
+		/* coalesce, like blame_coalesce() does */
+		while (i + 1 < nr && ents[i + 1]->suspect == ents[i]->suspect &&
+		       ents[i + 1]->s_lno == ents[i]->s_lno + ents[i]->num_lines) {
+			i++;
+			num_lines += ents[i]->num_lines;
+		}
+		o = bsearch(&ents[i]->suspect, origins, origins_nr,
+			    sizeof(*origins), compare_origin_ptr);
+		strbuf_addf(&buf, "e %d %d %d %d\n", lno, num_lines,
+			    ents[i]->s_lno + ents[i]->num_lines - num_lines,
+			    (int)(o - origins));
+	}
+
+	if (safe_create_leading_directories(file) ||
+	    hold_lock_file_for_update(&lk, file, 0) < 0)
+		goto out;
+	if (write_in_full(get_lock_file_fd(&lk), buf.buf, buf.len) < 0)
+		rollback_lock_file(&lk);
+	else
+		commit_lock_file(&lk);
+
+out:
+	free(ents);
+	free(origins);
+	free(file);
+	strbuf_release(&key);
+	strbuf_release(&buf);
+}
+
+void prune_blame_cache(struct repository *r, timestamp_t expire)
+{
+	struct strbuf path = STRBUF_INIT;
+	struct dirent *de;
+	size_t baselen;
+	DIR *dir;
+
+	strbuf_repo_git_path(&path, r, "blame-cache");
+	dir = opendir(path.buf);
+	if (!dir)
+		goto out;
+	strbuf_addch(&path, '/');
+	baselen = path.len;
+	while ((de = readdir_skip_dot_and_dotdot(dir))) {
+		struct dirent *file;
+		size_t dirlen;
+		DIR *subdir;
+
+		strbuf_setlen(&path, baselen);
+		strbuf_addstr(&path, de->d_name);
+		subdir = opendir(path.buf);
+		if (!subdir)
+			continue;
+		strbuf_addch(&path, '/');
+		dirlen = path.len;
+		while ((file = readdir_skip_dot_and_dotdot(subdir))) {
+			struct stat st;
+
+			strbuf_setlen(&path, dirlen);
+			strbuf_addstr(&path, file->d_name);
+			if (!stat(path.buf, &st) && st.st_mtime <= expire)
+				unlink_or_warn(path.buf);
+		}
+		closedir(subdir);
+		strbuf_setlen(&path, dirlen - 1);
+		rmdir(path.buf); /* only succeeds once it is empty */
+	}
+	closedir(dir);
+out:
+	strbuf_release(&path);
+}
+
+/*
+ * Shallow boundaries, grafts and replaced objects can change the
+ * history below a commit without changing the commit itself, so a
+ * cached result cannot be trusted in such a repository.
+ */
+static int blame_cache_compatible(struct repository *r)
+{
+	if (replace_refs_enabled(r)) {
+		prepare_replace_object(r);
+		if (hashmap_get_size(&r->objects->replace_map->map))
+			return 0;
+	}
+
+	prepare_commit_graft(r);
+	if (r->parsed_objects &&
+	    (r->parsed_objects->grafts_nr || r->parsed_objects->substituted_parent))
+		return 0;
+	if (is_repository_shallow(r))
+		return 0;
+
+	return 1;
+}
+
+void setup_blame_cache(struct blame_scoreboard *sb, int opt)
+{
+	struct userdiff_driver *textconv = NULL;
+	int i;
+
+	/*
+	 * Only cache results that depend on nothing but the commit, the
+	 * path and the diff options that go into the key.
+	 */
+	if (sb->reverse || opt || oidset_size(&sb->ignore_list) ||
+	    sb->revs->max_age != -1)
+		return;
+	for (i = 0; i < sb->revs->cmdline.nr; i++)
+		if (sb->revs->cmdline.rev[i].flags & UNINTERESTING)
+			return;
+	if (sb->revs->diffopt.flags.allow_textconv) {
+		textconv = userdiff_find_by_path(sb->repo->index, sb->path);
+		if (textconv)
+			textconv = userdiff_get_textconv(sb->repo, textconv);
+	}
+	if (textconv)
+		return;
+	if (!blame_cache_compatible(sb->repo))
+		return;
+	sb->use_cache = 1;
+}
+
 /*
  * The main loop -- while we have blobs with lines whose true origin
  * is still unknown, pick one blob, and allow its lines to pass blames
@@ -2602,11 +3450,15 @@ void assign_blame(struct blame_scoreboard *sb, int opt)
 		 */
 		blame_origin_incref(suspect);
 		repo_parse_commit(the_repository, commit);
-		if (sb->reverse ||
+		if (sb->use_cache && use_blame_cache(sb, suspect))
+			; /* all of its lines are taken care of */
+		else if (sb->reverse ||
 		    (!(commit->object.flags & UNINTERESTING) &&
-		     !(revs->max_age != -1 && commit->date < revs->max_age)))
+		     !(revs->max_age != -1 && commit->date < revs->max_age))) {
+			prefetch_blame_diffs(sb, suspect);
 			pass_blame(sb, suspect, opt);
-		else {
+			drop_blame_diff(sb, suspect);
+		} else {
 			commit->object.flags |= UNINTERESTING;
 			if (commit->object.parsed)
 				mark_parents_uninteresting(sb->revs, commit);
@@ -2638,6 +3490,11 @@ void assign_blame(struct blame_scoreboard *sb, int opt)
 		if (sb->debug) /* sanity */
 			sanity_check_refcnt(sb);
 	}
+
+	if (sb->use_cache) {
+		stop_blame_diff_threads(sb);
+		write_blame_cache(sb);
+	}
 }
 
 /*
@@ -2924,6 +3781,7 @@ void setup_blame_bloom_data(struct blame_scoreboard *sb)
 
 void cleanup_scoreboard(struct blame_scoreboard *sb)
 {
+	stop_blame_diff_threads(sb);
 	if (sb->bloom_data) {
 		int i;
 		for (i = 0; i < sb->bloom_data->nr; i++) {
@@ -2938,4 +3796,10 @@ void cleanup_scoreboard(struct blame_scoreboard *sb)
 		trace2_data_intmax("blame", sb->repo,
 				   "bloom/response-no", bloom_count_no);
 	}
+	if (sb->use_cache) {
+		trace2_data_intmax("blame", sb->repo,
+				   "cache/hits", blame_cache_hits);
+		trace2_data_intmax("blame", sb->repo,
+				   "cache/misses", blame_cache_misses);
+	}
 }
@@ -101,6 +101,7 @@ struct blame_entry {
 };
 
 struct blame_bloom_data;
+struct blame_diff_queue;
 
 /*
  * The current state of the blame assignment.
@@ -152,6 +153,7 @@ struct blame_scoreboard {
 	int xdl_opts;
 	int no_whole_file_rename;
 	int debug;
+	int use_cache;
 
 	/* callbacks */
 	void(*on_sanity_fail)(struct blame_scoreboard *, int);
@@ -159,6 +161,7 @@ struct blame_scoreboard {
 
 	void *found_guilty_entry_data;
 	struct blame_bloom_data *bloom_data;
+	struct blame_diff_queue *diff_queue;
 };
 
 /*
@@ -183,8 +186,16 @@ void init_scoreboard(struct blame_scoreboard *sb);
 void setup_scoreboard(struct blame_scoreboard *sb,
 		      struct blame_origin **orig);
 void setup_blame_bloom_data(struct blame_scoreboard *sb);
+void setup_blame_cache(struct blame_scoreboard *sb, int opt);
+void setup_blame_diff_threads(struct blame_scoreboard *sb, int nr_threads);
 void cleanup_scoreboard(struct blame_scoreboard *sb);
 
+/*
+ * Remove the results cached by "blame.cache" that have not been used
+ * since "expire".
+ */
+void prune_blame_cache(struct repository *r, timestamp_t expire);
+
 struct blame_entry *blame_entry_prepend(struct blame_entry *head,
 					long start, long end,
 					struct blame_origin *o);
@@ -144,6 +144,42 @@ void clear_bloom_key(struct bloom_key *key)
 	FREE_AND_NULL(key->hashes);
 }
 
+void fill_bloom_keyvec(struct bloom_keyvec *vec, const char *path, size_t len,
+		       const struct bloom_filter_settings *settings)
+{
+	const char *p;
+	int nr = 1;
+
+	/*
+	 * At this point, the path is normalized to use Unix-style
+	 * path separators. This is required due to how the
+	 * changed-path Bloom filters store the paths.
+	 */
+	for (p = path; p < path + len; p++)
+		if (*p == '/')
+			nr++;
+
+	ALLOC_ARRAY(vec->keys, nr);
+	fill_bloom_key(path, len, &vec->keys[0], settings);
+	nr = 1;
+
+	for (p = path + len - 1; p > path; p--)
+		if (*p == '/')
+			fill_bloom_key(path, p - path, &vec->keys[nr++], settings);
+
+	vec->nr = nr;
+}
+
+void clear_bloom_keyvec(struct bloom_keyvec *vec)
+{
+	int i;
+
+	for (i = 0; i < vec->nr; i++)
+		clear_bloom_key(&vec->keys[i]);
+	FREE_AND_NULL(vec->keys);
+	vec->nr = 0;
+}
+
 void add_key_to_filter(const struct bloom_key *key,
 		       struct bloom_filter *filter,
 		       const struct bloom_filter_settings *settings)
@@ -326,3 +362,14 @@ int bloom_filter_contains(const struct bloom_filter *filter,
 
 	return 1;
 }
+
+int bloom_filter_contains_vec(const struct bloom_filter *filter,
+			      const struct bloom_keyvec *vec,
+			      const struct bloom_filter_settings *settings)
+{
+	int i, result = 1;
+
+	for (i = 0; result && i < vec->nr; i++)
+		result = bloom_filter_contains(filter, &vec->keys[i], settings);
+	return result;
+}
@@ -83,6 +83,24 @@ void fill_bloom_key(const char *data,
 		    const struct bloom_filter_settings *settings);
 void clear_bloom_key(struct bloom_key *key);
 
+/*
+ * The keys for a path and each of its leading directories: the writer
+ * adds all of them to the filter of a commit that changes the path, so
+ * a commit can only have changed it if the filter contains every one.
+ */
+struct bloom_keyvec {
+	struct bloom_key *keys;
+	int nr;
+};
+
+/*
+ * Fill "vec" with the keys for the "len" bytes of "path" followed by
+ * the keys for each of its leading directories.
+ */
+void fill_bloom_keyvec(struct bloom_keyvec *vec, const char *path, size_t len,
+		       const struct bloom_filter_settings *settings);
+void clear_bloom_keyvec(struct bloom_keyvec *vec);
+
 void add_key_to_filter(const struct bloom_key *key,
 		       struct bloom_filter *filter,
 		       const struct bloom_filter_settings *settings);
@@ -109,4 +127,12 @@ int bloom_filter_contains(const struct bloom_filter *filter,
 			  const struct bloom_key *key,
 			  const struct bloom_filter_settings *settings);
 
+/*
+ * Like bloom_filter_contains(), but for all the keys in "vec": returns
+ * 0 if the filter is missing any of them.
+ */
+int bloom_filter_contains_vec(const struct bloom_filter *filter,
+			      const struct bloom_keyvec *vec,
+			      const struct bloom_filter_settings *settings);
+
 #endif
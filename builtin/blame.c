@@ -35,6 +35,7 @@
 #include "refs.h"
 #include "setup.h"
 #include "tag.h"
+#include "thread-utils.h"
 #include "write-or-die.h"
 
 static char blame_usage[] = N_("git blame [<options>] [<rev-opts>] [<rev>] [--] <file>");
@@ -72,6 +73,8 @@ static int coloring_mode;
 static struct string_list ignore_revs_file_list = STRING_LIST_INIT_NODUP;
 static int mark_unblamable_lines;
 static int mark_ignored_lines;
+static int use_blame_cache;
+static int blame_threads = 1;
 
 static struct date_mode blame_date_mode = { DATE_ISO8601 };
 static size_t blame_date_width;
@@ -737,6 +740,19 @@ static int git_blame_config(const char *var, const char *value,
 		mark_ignored_lines = git_config_bool(var, value);
 		return 0;
 	}
+	if (!strcmp(var, "blame.cache")) {
+		use_blame_cache = git_config_bool(var, value);
+		return 0;
+	}
+	if (!strcmp(var, "blame.threads")) {
+		blame_threads = git_config_int(var, value, ctx->kvi);
+		if (blame_threads < 0)
+			die(_("invalid number of threads specified (%d) for %s"),
+			    blame_threads, var);
+		if (!blame_threads)
+			blame_threads = online_cpus();
+		return 0;
+	}
 	if (!strcmp(var, "color.blame.repeatedlines")) {
 		if (color_parse_mem(value, strlen(value), repeated_meta_color))
 			warning(_("invalid value for '%s': '%s'"),
@@ -1177,6 +1193,9 @@ int cmd_blame(int argc, const char **argv, const char *prefix)
 	sb.show_root = show_root;
 	sb.xdl_opts = xdl_opts;
 	sb.no_whole_file_rename = no_whole_file_rename;
+	if (use_blame_cache)
+		setup_blame_cache(&sb, opt);
+	setup_blame_diff_threads(&sb, blame_threads);
 
 	read_mailmap(&mailmap);
 
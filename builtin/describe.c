@@ -22,6 +22,7 @@
 #include "object-store-ll.h"
 #include "list-objects.h"
 #include "commit-slab.h"
+#include "prio-queue.h"
 #include "wildmatch.h"
 
 #define MAX_TAGS	(FLAG_BITS - 1)
@@ -31,6 +32,7 @@ define_commit_slab(commit_names, struct commit_name *);
 static const char * const describe_usage[] = {
 	N_("git describe [--all] [--tags] [--contains] [--abbrev=<n>] [<commit-ish>...]"),
 	N_("git describe [--all] [--tags] [--contains] [--abbrev=<n>] --dirty[=<mark>]"),
+	N_("git describe [--all] [--tags] [--abbrev=<n>] --stdin"),
 	N_("git describe <blob>"),
 	NULL
 };
@@ -245,23 +247,22 @@ static int compare_pt(const void *a_, const void *b_)
 }
 
 static unsigned long finish_depth_computation(
-	struct commit_list **list,
+	struct prio_queue *queue,
 	struct possible_tag *best)
 {
 	unsigned long seen_commits = 0;
-	while (*list) {
-		struct commit *c = pop_commit(list);
+	while (queue->nr) {
+		struct commit *c = prio_queue_get(queue);
 		struct commit_list *parents = c->parents;
 		seen_commits++;
 		if (c->object.flags & best->flag_within) {
-			struct commit_list *a = *list;
-			while (a) {
-				struct commit *i = a->item;
-				if (!(i->object.flags & best->flag_within))
+			int i;
+			for (i = 0; i < queue->nr; i++) {
+				struct commit *item = queue->array[i].data;
+				if (!(item->object.flags & best->flag_within))
 					break;
-				a = a->next;
 			}
-			if (!a)
+			if (i == queue->nr)
 				break;
 		} else
 			best->depth++;
@@ -269,7 +270,7 @@ static unsigned long finish_depth_computation(
 			struct commit *p = parents->item;
 			repo_parse_commit(the_repository, p);
 			if (!(p->object.flags & SEEN))
-				commit_list_insert_by_date(p, list);
+				prio_queue_put(queue, p);
 			p->object.flags |= c->object.flags;
 			parents = parents->next;
 		}
@@ -311,7 +312,7 @@ static void append_suffix(int depth, const struct object_id *oid, struct strbuf
 static void describe_commit(struct object_id *oid, struct strbuf *dst)
 {
 	struct commit *cmit, *gave_up_on = NULL;
-	struct commit_list *list;
+	struct prio_queue queue = { compare_commits_by_commit_date };
 	struct commit_name *n;
 	struct possible_tag all_matches[MAX_TAGS];
 	unsigned int match_cnt = 0, annotated_cnt = 0, cur_match;
@@ -354,11 +355,10 @@ static void describe_commit(struct object_id *oid, struct strbuf *dst)
 		have_util = 1;
 	}
 
-	list = NULL;
 	cmit->object.flags = SEEN;
-	commit_list_insert(cmit, &list);
-	while (list) {
-		struct commit *c = pop_commit(&list);
+	prio_queue_put(&queue, cmit);
+	while (queue.nr) {
+		struct commit *c = prio_queue_get(&queue);
 		struct commit_list *parents = c->parents;
 		struct commit_name **slot;
 
@@ -389,7 +389,7 @@ static void describe_commit(struct object_id *oid, struct strbuf *dst)
 				t->depth++;
 		}
 		/* Stop if last remaining path already covered by best candidate(s) */
-		if (annotated_cnt && !list) {
+		if (annotated_cnt && !queue.nr) {
 			int best_depth = INT_MAX;
 			unsigned best_within = 0;
 			for (cur_match = 0; cur_match < match_cnt; cur_match++) {
@@ -412,7 +412,7 @@ static void describe_commit(struct object_id *oid, struct strbuf *dst)
 			struct commit *p = parents->item;
 			repo_parse_commit(the_repository, p);
 			if (!(p->object.flags & SEEN))
-				commit_list_insert_by_date(p, &list);
+				prio_queue_put(&queue, p);
 			p->object.flags |= c->object.flags;
 			parents = parents->next;
 
@@ -423,6 +423,7 @@ static void describe_commit(struct object_id *oid, struct strbuf *dst)
 
 	if (!match_cnt) {
 		struct object_id *cmit_oid = &cmit->object.oid;
+		clear_prio_queue(&queue);
 		if (always) {
 			strbuf_add_unique_abbrev(dst, cmit_oid, abbrev);
 			if (suffix)
@@ -442,11 +443,11 @@ static void describe_commit(struct object_id *oid, struct strbuf *dst)
 	QSORT(all_matches, match_cnt, compare_pt);
 
 	if (gave_up_on) {
-		commit_list_insert_by_date(gave_up_on, &list);
+		prio_queue_put(&queue, gave_up_on);
 		seen_commits--;
 	}
-	seen_commits += finish_depth_computation(&list, &all_matches[0]);
-	free_commit_list(list);
+	seen_commits += finish_depth_computation(&queue, &all_matches[0]);
+	clear_prio_queue(&queue);
 
 	if (debug) {
 		static int label_width = -1;
@@ -559,7 +560,7 @@ static void describe(const char *arg, int last_one)
 
 int cmd_describe(int argc, const char **argv, const char *prefix)
 {
-	int contains = 0;
+	int contains = 0, from_stdin = 0;
 	struct option options[] = {
 		OPT_BOOL(0, "contains",   &contains, N_("find the tag that comes after the commit")),
 		OPT_BOOL(0, "debug",      &debug, N_("debug search strategy on stderr")),
@@ -578,6 +579,8 @@ int cmd_describe(int argc, const char **argv, const char *prefix)
 			   N_("do not consider tags matching <pattern>")),
 		OPT_BOOL(0, "always",        &always,
 			N_("show abbreviated commit object as fallback")),
+		OPT_BOOL(0, "stdin", &from_stdin,
+			 N_("read commit-ishes to describe from stdin")),
 		{OPTION_STRING, 0, "dirty",  &dirty, N_("mark"),
 			N_("append <mark> on dirty working tree (default: \"-dirty\")"),
 			PARSE_OPT_OPTARG, NULL, (intptr_t) "-dirty"},
@@ -602,6 +605,17 @@ int cmd_describe(int argc, const char **argv, const char *prefix)
 	if (longformat && abbrev == 0)
 		die(_("options '%s' and '%s' cannot be used together"), "--long", "--abbrev=0");
 
+	if (from_stdin) {
+		if (contains)
+			die(_("options '%s' and '%s' cannot be used together"), "--stdin", "--contains");
+		if (dirty)
+			die(_("options '%s' and '%s' cannot be used together"), "--stdin", "--dirty");
+		if (broken)
+			die(_("options '%s' and '%s' cannot be used together"), "--stdin", "--broken");
+		if (argc)
+			die(_("option '%s' and commit-ishes cannot be used together"), "--stdin");
+	}
+
 	if (contains) {
 		struct string_list_item *item;
 		struct strvec args;
@@ -631,7 +645,19 @@ int cmd_describe(int argc, const char **argv, const char *prefix)
 	if (!hashmap_get_size(&names) && !always)
 		die(_("No names found, cannot describe anything."));
 
-	if (argc == 0) {
+	if (from_stdin) {
+		struct strbuf line = STRBUF_INIT;
+
+		/*
+		 * The refs have been read and the names to describe with
+		 * are set up once; each line only pays for its own walk.
+		 */
+		while (strbuf_getline(&line, stdin) != EOF) {
+			describe(line.buf, 0);
+			fflush(stdout);
+		}
+		strbuf_release(&line);
+	} else if (argc == 0) {
 		if (broken) {
 			struct child_process cp = CHILD_PROCESS_INIT;
 			strvec_pushv(&cp.args, diff_index_args);
@@ -12,6 +12,7 @@
 
 #include "builtin.h"
 #include "abspath.h"
+#include "blame.h"
 #include "date.h"
 #include "environment.h"
 #include "hex.h"
@@ -62,6 +63,7 @@ static timestamp_t gc_log_expire_time;
 static const char *gc_log_expire = "1.day.ago";
 static const char *prune_expire = "2.weeks.ago";
 static const char *prune_worktrees_expire = "3.months.ago";
+static const char *blame_cache_expire = "1.month.ago";
 static unsigned long big_pack_threshold;
 static unsigned long max_delta_cache_size = DEFAULT_DELTA_CACHE_SIZE;
 
@@ -166,6 +168,7 @@ static void gc_config(void)
 	git_config_get_bool("gc.cruftpacks", &cruft_packs);
 	git_config_get_expiry("gc.pruneexpire", &prune_expire);
 	git_config_get_expiry("gc.worktreepruneexpire", &prune_worktrees_expire);
+	git_config_get_expiry("gc.blamecacheexpire", &blame_cache_expire);
 	git_config_get_expiry("gc.logexpiry", &gc_log_expire);
 
 	git_config_get_ulong("gc.bigpackthreshold", &big_pack_threshold);
@@ -730,6 +733,16 @@ int cmd_gc(int argc, const char **argv, const char *prefix)
 	if (run_command(&rerere_cmd))
 		die(FAILED_RUN, rerere.v[0]);
 
+	if (blame_cache_expire) {
+		timestamp_t expire;
+
+		if (parse_expiry_date(blame_cache_expire, &expire))
+			die(_("failed to parse gc.blameCacheExpire value %s"),
+			    blame_cache_expire);
+		if (expire)
+			prune_blame_cache(the_repository, expire);
+	}
+
 	report_garbage = report_pack_garbage;
 	reprepare_packed_git(the_repository);
 	if (pack_garbage.nr > 0) {
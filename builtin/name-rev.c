@@ -9,6 +9,7 @@
 #include "tag.h"
 #include "refs.h"
 #include "object-name.h"
+#include "object-store-ll.h"
 #include "pager.h"
 #include "parse-options.h"
 #include "prio-queue.h"
@@ -37,6 +38,28 @@ static timestamp_t generation_cutoff = GENERATION_NUMBER_INFINITY;
 static timestamp_t cutoff = TIME_MAX;
 static struct commit_rev_name rev_names;
 
+/*
+ * The tip names handed out to rev_names; a name is shared by all the
+ * commits reached from its tip, so they are freed all at once.
+ */
+static char **tip_names;
+static size_t tip_names_nr, tip_names_alloc;
+
+static const char *add_tip_name(char *tip_name)
+{
+	ALLOC_GROW(tip_names, tip_names_nr + 1, tip_names_alloc);
+	tip_names[tip_names_nr++] = tip_name;
+	return tip_name;
+}
+
+static void free_tip_names(void)
+{
+	while (tip_names_nr)
+		free(tip_names[--tip_names_nr]);
+	FREE_AND_NULL(tip_names);
+	tip_names_alloc = 0;
+}
+
 /* Disable the cutoff checks entirely */
 static void disable_cutoff(void)
 {
@@ -196,9 +219,9 @@ static void name_rev(struct commit *start_commit,
 	if (!start_name)
 		return;
 	if (deref)
-		start_name->tip_name = xstrfmt("%s^0", tip_name);
+		start_name->tip_name = add_tip_name(xstrfmt("%s^0", tip_name));
 	else
-		start_name->tip_name = xstrdup(tip_name);
+		start_name->tip_name = add_tip_name(xstrdup(tip_name));
 
 	memset(&queue, 0, sizeof(queue)); /* Use the prio_queue as LIFO */
 	prio_queue_put(&queue, start_commit);
@@ -235,8 +258,8 @@ static void name_rev(struct commit *start_commit,
 			if (parent_name) {
 				if (parent_number > 1)
 					parent_name->tip_name =
-						get_parent_name(name,
-								parent_number);
+						add_tip_name(get_parent_name(name,
+									     parent_number));
 				else
 					parent_name->tip_name = name->tip_name;
 				ALLOC_GROW(parents_to_queue,
@@ -342,7 +365,7 @@ static int cmp_by_tag_and_age(const void *a_, const void *b_)
 static int name_ref(const char *path, const struct object_id *oid,
 		    int flags UNUSED, void *cb_data)
 {
-	struct object *o = parse_object(the_repository, oid);
+	struct object *o;
 	struct name_ref_data *data = cb_data;
 	int can_abbreviate_output = data->tags_only && data->name_only;
 	int deref = 0;
@@ -396,11 +419,18 @@ static int name_ref(const char *path, const struct object_id *oid,
 			return 0;
 	}
 
+	/*
+	 * There can be very many refs; do not read and hash every commit
+	 * they point at when the commit-graph already knows them.
+	 */
+	o = parse_object_with_flags(the_repository, oid,
+				    PARSE_OBJECT_SKIP_HASH_CHECK);
 	while (o && o->type == OBJ_TAG) {
 		struct tag *t = (struct tag *) o;
 		if (!t->tagged)
 			break; /* broken repository */
-		o = parse_object(the_repository, &t->tagged->oid);
+		o = parse_object_with_flags(the_repository, &t->tagged->oid,
+					    PARSE_OBJECT_SKIP_HASH_CHECK);
 		deref = 1;
 		taggerdate = t->date;
 	}
@@ -416,17 +446,26 @@ static int name_ref(const char *path, const struct object_id *oid,
 	return 0;
 }
 
+static struct tip_table_entry *tips_by_age;
+
 static void name_tips(void)
 {
 	int i;
 
 	/*
 	 * Try to set better names first, so that worse ones spread
-	 * less.
+	 * less.  The table itself gets sorted by object name for exact
+	 * matches, so keep this order in a copy of its own; we may be
+	 * called again with a lower cutoff, and must then visit the
+	 * tips in the same order.
 	 */
-	QSORT(tip_table.table, tip_table.nr, cmp_by_tag_and_age);
+	if (!tips_by_age) {
+		ALLOC_ARRAY(tips_by_age, tip_table.nr);
+		COPY_ARRAY(tips_by_age, tip_table.table, tip_table.nr);
+		QSORT(tips_by_age, tip_table.nr, cmp_by_tag_and_age);
+	}
 	for (i = 0; i < tip_table.nr; i++) {
-		struct tip_table_entry *e = &tip_table.table[i];
+		struct tip_table_entry *e = &tips_by_age[i];
 		if (e->commit) {
 			name_rev(e->commit, e->refname, e->taggerdate,
 				 e->from_tag, e->deref);
@@ -434,6 +473,71 @@ static void name_tips(void)
 	}
 }
 
+/*
+ * With --annotate-stdin we do not know up front which commits will
+ * be asked about, and naming all of history can take long before the
+ * first line comes out.  With generation numbers, the names of commits
+ * at or above a generation depend only on the walk above it, so name
+ * the tips only down to the generation of the commit asked about, and
+ * start over with a lower cutoff when a later line needs an older
+ * commit.  Each time, go twice as far below the newest tip as needed,
+ * so that the repeated walks add up to a small multiple of one walk.
+ */
+static int lazy_names;
+
+static timestamp_t newest_tip_generation(void)
+{
+	timestamp_t max = 0;
+	int i;
+
+	for (i = 0; i < tip_table.nr; i++) {
+		struct commit *c = tip_table.table[i].commit;
+		timestamp_t generation;
+
+		if (!c)
+			continue;
+		generation = commit_graph_generation(c);
+		if (generation != GENERATION_NUMBER_INFINITY && max < generation)
+			max = generation;
+	}
+	return max;
+}
+
+static void name_tips_down_to(const struct object_id *oid)
+{
+	struct commit *commit;
+	timestamp_t generation;
+
+	if (!generation_cutoff)
+		return; /* everything is named already */
+
+	commit = lookup_commit_in_graph(the_repository, oid);
+	if (commit)
+		generation = commit_graph_generation(commit);
+	else if (oid_object_info(the_repository, oid, NULL) == OBJ_COMMIT)
+		generation = 0; /* not in the commit-graph; name everything */
+	else
+		return;
+
+	if (generation >= generation_cutoff)
+		return;
+	if (generation) {
+		static timestamp_t top = GENERATION_NUMBER_INFINITY;
+		timestamp_t depth;
+
+		if (top == GENERATION_NUMBER_INFINITY)
+			top = newest_tip_generation();
+		depth = top > generation ? top - generation : 0;
+		generation = generation > depth ? generation - depth : 0;
+	}
+	generation_cutoff = generation;
+
+	clear_commit_rev_name(&rev_names);
+	init_commit_rev_name(&rev_names);
+	free_tip_names();
+	name_tips();
+}
+
 static const struct object_id *nth_tip_table_ent(size_t ix, const void *table_)
 {
 	const struct tip_table_entry *table = table_;
@@ -535,8 +639,11 @@ static void name_rev_line(char *p, struct name_ref_data *data)
 
 			*(p+1) = 0;
 			if (!repo_get_oid(the_repository, p - (hexsz - 1), &oid)) {
-				struct object *o =
-					lookup_object(the_repository, &oid);
+				struct object *o;
+
+				if (lazy_names)
+					name_tips_down_to(&oid);
+				o = lookup_object(the_repository, &oid);
 				if (o)
 					name = get_rev_name(o, &buf);
 			}
@@ -607,7 +714,11 @@ int cmd_name_rev(int argc, const char **argv, const char *prefix)
 		error("Specify either a list, or --all, not both!");
 		usage_with_options(name_rev_usage, opts);
 	}
-	if (all || annotate_stdin)
+	if (annotate_stdin && generation_numbers_enabled(the_repository)) {
+		/* see name_tips_down_to() */
+		lazy_names = 1;
+		cutoff = 0;
+	} else if (all || annotate_stdin)
 		disable_cutoff();
 
 	for (; argc; argc--, argv++) {
@@ -653,7 +764,8 @@ int cmd_name_rev(int argc, const char **argv, const char *prefix)
 	adjust_cutoff_timestamp_for_slop();
 
 	for_each_ref(name_ref, &data);
-	name_tips();
+	if (!lazy_names)
+		name_tips();
 
 	if (annotate_stdin) {
 		struct strbuf sb = STRBUF_INIT;
@@ -682,5 +794,8 @@ int cmd_name_rev(int argc, const char **argv, const char *prefix)
 	}
 
 	UNLEAK(revs);
+	clear_commit_rev_name(&rev_names);
+	free_tip_names();
+	free(tips_by_age);
 	return 0;
 }
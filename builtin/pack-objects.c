@@ -325,10 +325,17 @@ static unsigned long do_compress(void **pptr, unsigned long size)
 	void *in, *out;
 	unsigned long maxsize;
 
+	in = *pptr;
+	out = git_deflate_whole(in, size, pack_compression_level, &maxsize);
+	if (out) {
+		*pptr = out;
+		free(in);
+		return maxsize;
+	}
+
 	git_deflate_init(&stream, pack_compression_level);
 	maxsize = git_deflate_bound(&stream, size);
 
-	in = *pptr;
 	out = xmalloc(maxsize);
 	*pptr = out;
 
@@ -160,15 +160,57 @@ void cache_tree_invalidate_path(struct index_state *istate, const char *path)
 		istate->cache_changed |= CACHE_TREE_CHANGED;
 }
 
+/*
+ * The entries covered by a valid cache-tree were written out as a tree
+ * and have not changed since, so they are known to be merged and free
+ * of path vs path/file conflicts. Return how many entries, starting
+ * with "ce", are covered by the outermost valid subtree "ce" falls in,
+ * or 0 if there is none. The caller only asks about the first entry
+ * after a span it has already looked at, which is the first entry of
+ * any such subtree.
+ */
+static unsigned valid_cache_tree_span(const struct index_state *istate,
+				      const struct cache_entry *ce,
+				      unsigned pos)
+{
+	struct cache_tree *it = istate->cache_tree;
+	const char *path = ce->name;
+	const char *slash;
+
+	while (it) {
+		struct cache_tree_sub *sub;
+
+		if (0 <= it->entry_count) {
+			if (istate->cache_nr - pos < (unsigned)it->entry_count)
+				return 0;
+			return it->entry_count;
+		}
+		slash = strchr(path, '/');
+		if (!slash)
+			return 0;
+		sub = find_subtree(it, path, slash - path, 0);
+		if (!sub)
+			return 0;
+		it = sub->cache_tree;
+		path = slash + 1;
+	}
+	return 0;
+}
+
 static int verify_cache(struct index_state *istate, int flags)
 {
-	unsigned i, funny;
+	unsigned i, funny, span;
 	int silent = flags & WRITE_TREE_SILENT;
 
 	/* Verify that the tree is merged */
 	funny = 0;
 	for (i = 0; i < istate->cache_nr; i++) {
 		const struct cache_entry *ce = istate->cache[i];
+		span = valid_cache_tree_span(istate, ce, i);
+		if (span) {
+			i += span - 1;
+			continue;
+		}
 		if (ce_stage(ce)) {
 			if (silent)
 				return -1;
@@ -198,6 +240,17 @@ static int verify_cache(struct index_state *istate, int flags)
 		const char *this_name = this_ce->name;
 		const char *next_name = next_ce->name;
 		int this_len = ce_namelen(this_ce);
+
+		/*
+		 * The entry before a valid subtree has been compared
+		 * with its first entry already, and the entry after it
+		 * is outside of it, so the whole span can be skipped.
+		 */
+		span = valid_cache_tree_span(istate, this_ce, i);
+		if (span) {
+			i += span - 1;
+			continue;
+		}
 		if (this_len < ce_namelen(next_ce) &&
 		    next_name[this_len] == '/' &&
 		    strncmp(this_name, next_name, this_len) == 0) {
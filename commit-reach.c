@@ -11,6 +11,7 @@
 #include "tag.h"
 #include "commit-reach.h"
 #include "ewah/ewok.h"
+#include "trace2.h"
 
 /* Remember to update object flag allocation in object.h */
 #define PARENT1		(1u<<16)
@@ -986,6 +987,7 @@ void ahead_behind(struct repository *r,
 {
 	struct prio_queue queue = { .compare = compare_commits_by_gen_then_commit_date };
 	size_t width = DIV_ROUND_UP(commits_nr, BITS_IN_EWORD);
+	intmax_t nr_walked = 0, nr_counted = 0;
 
 	if (!commits_nr || !counts_nr)
 		return;
@@ -1011,8 +1013,19 @@ void ahead_behind(struct repository *r,
 		struct commit *c = prio_queue_get(&queue);
 		struct commit_list *p;
 		struct bitmap *bitmap_c = get_bit_array(c, width);
+		int stale = !!(c->object.flags & STALE);
 
-		for (size_t i = 0; i < counts_nr; i++) {
+		nr_walked++;
+		if (!stale)
+			nr_counted++;
+
+		/*
+		 * A STALE commit is reachable from every starting commit,
+		 * so it is on both sides of every pair and does not count.
+		 * There can be many of them in the queue before the walk
+		 * stops, so do not look at every pair for each of them.
+		 */
+		for (size_t i = 0; !stale && i < counts_nr; i++) {
 			int reach_from_tip = !!bitmap_get(bitmap_c, counts[i].tip_index);
 			int reach_from_base = !!bitmap_get(bitmap_c, counts[i].base_index);
 
@@ -1039,7 +1052,7 @@ void ahead_behind(struct repository *r,
 			 * we can stop the walk when every commit in the
 			 * queue is STALE.
 			 */
-			if (bitmap_popcount(bitmap_p) == commits_nr)
+			if (stale || bitmap_popcount(bitmap_p) == commits_nr)
 				p->item->object.flags |= STALE;
 
 			insert_no_dup(&queue, p->item);
@@ -1048,6 +1061,9 @@ void ahead_behind(struct repository *r,
 		free_bit_array(c);
 	}
 
+	trace2_data_intmax("ahead_behind", r, "walked", nr_walked);
+	trace2_data_intmax("ahead_behind", r, "counted", nr_counted);
+
 	/* STALE is used here, PARENT2 is used by insert_no_dup(). */
 	repo_clear_commit_marks(r, PARENT2 | STALE);
 	clear_bit_arrays(&bit_arrays);
@@ -1166,3 +1182,87 @@ void tips_reachable_from_bases(struct repository *r,
 	free(commits);
 	repo_clear_commit_marks(r, SEEN);
 }
+
+void tips_reaching_commits(struct repository *r,
+			   struct commit_list *commits,
+			   struct commit **tips, size_t tips_nr,
+			   int mark)
+{
+	struct commit **list;
+	struct commit_list *c;
+	timestamp_t min_generation = GENERATION_NUMBER_INFINITY;
+
+	if (!commits || !tips || !tips_nr)
+		return;
+
+	for (c = commits; c; c = c->next) {
+		timestamp_t generation;
+
+		if (repo_parse_commit(r, c->item))
+			continue;
+		c->item->object.flags |= PARENT1;
+		generation = commit_graph_generation(c->item);
+		if (generation < min_generation)
+			min_generation = generation;
+	}
+
+	/*
+	 * Walk from the lowest tips first, so that the higher ones find
+	 * the answer already recorded (RESULT, or PARENT2 without it) for
+	 * the history they share. Below 'min_generation' no commit can
+	 * reach one of 'commits'.
+	 */
+	ALLOC_ARRAY(list, tips_nr);
+	COPY_ARRAY(list, tips, tips_nr);
+	QSORT(list, tips_nr, compare_commits_by_gen);
+
+	for (size_t i = 0; i < tips_nr; i++) {
+		struct commit_list *stack = NULL;
+		struct commit *tip = list[i];
+
+		if (!(tip->object.flags & PARENT2)) {
+			tip->object.flags |= PARENT2;
+			if (!repo_parse_commit(r, tip) &&
+			    commit_graph_generation(tip) >= min_generation)
+				commit_list_insert(tip, &stack);
+		}
+
+		while (stack) {
+			struct commit_list *parent;
+
+			if (stack->item->object.flags & (PARENT1 | RESULT)) {
+				pop_commit(&stack);
+				if (stack)
+					stack->item->object.flags |= RESULT;
+				continue;
+			}
+
+			for (parent = stack->item->parents; parent; parent = parent->next) {
+				if (parent->item->object.flags & (PARENT1 | RESULT))
+					stack->item->object.flags |= RESULT;
+
+				if (!(parent->item->object.flags & PARENT2)) {
+					parent->item->object.flags |= PARENT2;
+
+					if (repo_parse_commit(r, parent->item) ||
+					    commit_graph_generation(parent->item) < min_generation)
+						continue;
+
+					commit_list_insert(parent->item, &stack);
+					break;
+				}
+			}
+
+			if (!parent)
+				pop_commit(&stack);
+		}
+
+		if (tip->object.flags & (PARENT1 | RESULT))
+			tip->object.flags |= mark;
+	}
+
+	clear_commit_marks_many(tips_nr, list, PARENT1 | PARENT2 | RESULT);
+	for (c = commits; c; c = c->next)
+		c->item->object.flags &= ~PARENT1;
+	free(list);
+}
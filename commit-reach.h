@@ -135,4 +135,15 @@ void tips_reachable_from_bases(struct repository *r,
 			       struct commit **tips, size_t tips_nr,
 			       int mark);
 
+/*
+ * For all tip commits, add 'mark' to their flags if and only if one of
+ * the commits in 'commits' is reachable from them. The answer for a
+ * commit is remembered for the whole call, so tips with a shared
+ * history are walked only once.
+ */
+void tips_reaching_commits(struct repository *r,
+			   struct commit_list *commits,
+			   struct commit **tips, size_t tips_nr,
+			   int mark);
+
 #endif
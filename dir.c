@@ -28,8 +28,10 @@
 #include "read-cache-ll.h"
 #include "setup.h"
 #include "sparse-index.h"
+#include "string-list.h"
 #include "submodule-config.h"
 #include "symlinks.h"
+#include "thread-utils.h"
 #include "trace2.h"
 #include "tree.h"
 #include "wrapper.h"
@@ -935,6 +937,88 @@ static int read_skip_worktree_file_from_index(struct index_state *istate,
 	return do_read_blob(&istate->cache[pos]->oid, oid_stat, size_out, data_out);
 }
 
+/*
+ * All patterns of a pattern_list that share the same literal basename
+ * (or the same literal suffix), by their position in the list.
+ */
+struct pattern_index_entry {
+	struct hashmap_entry ent;
+	const char *key;
+	int keylen;
+	int *pos;
+	int nr, alloc;
+};
+
+static int pattern_index_cmp(const void *cmp_data UNUSED,
+			     const struct hashmap_entry *a,
+			     const struct hashmap_entry *b,
+			     const void *key UNUSED)
+{
+	const struct pattern_index_entry *e1 =
+		container_of(a, struct pattern_index_entry, ent);
+	const struct pattern_index_entry *e2 =
+		container_of(b, struct pattern_index_entry, ent);
+
+	return e1->keylen != e2->keylen ||
+	       fspathncmp(e1->key, e2->key, e1->keylen);
+}
+
+static unsigned int pattern_index_hash(const char *key, int keylen)
+{
+	return ignore_case ? memihash(key, keylen) : memhash(key, keylen);
+}
+
+static struct pattern_index_entry *pattern_index_get(struct hashmap *map,
+						     const char *key,
+						     int keylen)
+{
+	struct pattern_index_entry k;
+
+	hashmap_entry_init(&k.ent, pattern_index_hash(key, keylen));
+	k.key = key;
+	k.keylen = keylen;
+	return hashmap_get_entry(map, &k, ent, NULL);
+}
+
+static void pattern_index_add(struct hashmap *map, const char *key,
+			      int keylen, int pos)
+{
+	struct pattern_index_entry *e = pattern_index_get(map, key, keylen);
+
+	if (!e) {
+		CALLOC_ARRAY(e, 1);
+		hashmap_entry_init(&e->ent, pattern_index_hash(key, keylen));
+		e->key = key;
+		e->keylen = keylen;
+		hashmap_add(map, &e->ent);
+	}
+	ALLOC_GROW(e->pos, e->nr + 1, e->alloc);
+	e->pos[e->nr++] = pos;
+}
+
+static void clear_pattern_index_map(struct hashmap *map)
+{
+	struct hashmap_iter iter;
+	struct pattern_index_entry *e;
+
+	hashmap_for_each_entry(map, &iter, e, ent)
+		free(e->pos);
+	hashmap_clear_and_free(map, struct pattern_index_entry, ent);
+}
+
+static void clear_pattern_index(struct pattern_list *pl)
+{
+	if (!pl->indexed_nr)
+		return;
+	clear_pattern_index_map(&pl->basename_hashmap);
+	clear_pattern_index_map(&pl->suffix_hashmap);
+	FREE_AND_NULL(pl->suffix_lens);
+	FREE_AND_NULL(pl->other_patterns);
+	pl->suffix_lens_nr = pl->suffix_lens_alloc = 0;
+	pl->other_patterns_nr = pl->other_patterns_alloc = 0;
+	pl->indexed_nr = 0;
+}
+
 /*
  * Frees memory within pl which was allocated for exclude patterns and
  * the file buffer.  Does not free pl itself.
@@ -949,6 +1033,7 @@ void clear_pattern_list(struct pattern_list *pl)
 	free(pl->filebuf);
 	hashmap_clear_and_free(&pl->recursive_hashmap, struct pattern_entry, ent);
 	hashmap_clear_and_free(&pl->parent_hashmap, struct pattern_entry, ent);
+	clear_pattern_index(pl);
 
 	memset(pl, 0, sizeof(*pl));
 }
@@ -1320,11 +1405,84 @@ int match_pathname(const char *pathname, int pathlen,
 				 WM_PATHNAME) == 0;
 }
 
+/*
+ * Index the patterns added to "pl" since we last looked. Patterns are
+ * only ever appended, so the positions stored in each bucket stay in
+ * increasing order.
+ */
+static void index_patterns(struct pattern_list *pl)
+{
+	int i, j;
+
+	if (!pl->indexed_nr) {
+		hashmap_init(&pl->basename_hashmap, pattern_index_cmp, NULL, 0);
+		hashmap_init(&pl->suffix_hashmap, pattern_index_cmp, NULL, 0);
+	}
+
+	for (i = pl->indexed_nr; i < pl->nr; i++) {
+		struct path_pattern *pattern = pl->patterns[i];
+		int len = pattern->patternlen;
+
+		if (!(pattern->flags & PATTERN_FLAG_NODIR)) {
+			ALLOC_GROW(pl->other_patterns, pl->other_patterns_nr + 1,
+				   pl->other_patterns_alloc);
+			pl->other_patterns[pl->other_patterns_nr++] = i;
+		} else if (pattern->nowildcardlen == len) {
+			pattern_index_add(&pl->basename_hashmap,
+					  pattern->pattern, len, i);
+		} else if (pattern->flags & PATTERN_FLAG_ENDSWITH) {
+			pattern_index_add(&pl->suffix_hashmap,
+					  pattern->pattern + 1, len - 1, i);
+			for (j = 0; j < pl->suffix_lens_nr; j++)
+				if (pl->suffix_lens[j] == len - 1)
+					break;
+			if (j == pl->suffix_lens_nr) {
+				ALLOC_GROW(pl->suffix_lens, pl->suffix_lens_nr + 1,
+					   pl->suffix_lens_alloc);
+				pl->suffix_lens[pl->suffix_lens_nr++] = len - 1;
+			}
+		} else {
+			ALLOC_GROW(pl->other_patterns, pl->other_patterns_nr + 1,
+				   pl->other_patterns_alloc);
+			pl->other_patterns[pl->other_patterns_nr++] = i;
+		}
+	}
+	pl->indexed_nr = pl->nr;
+}
+
+/*
+ * Return the position of the last pattern in bucket "e" that is
+ * after "after" and applies to the path, or "after" if there is none.
+ */
+static int last_indexed_match(struct pattern_index_entry *e, int after,
+			      const char *pathname, int pathlen, int *dtype,
+			      struct pattern_list *pl,
+			      struct index_state *istate)
+{
+	int i;
+
+	for (i = e->nr - 1; 0 <= i && after < e->pos[i]; i--) {
+		struct path_pattern *pattern = pl->patterns[e->pos[i]];
+
+		if (pattern->flags & PATTERN_FLAG_MUSTBEDIR) {
+			*dtype = resolve_dtype(*dtype, istate, pathname, pathlen);
+			if (*dtype != DT_DIR)
+				continue;
+		}
+		return e->pos[i];
+	}
+	return after;
+}
+
 /*
  * Scan the given exclude list in reverse to see whether pathname
  * should be ignored.  The first match (i.e. the last on the list), if
  * any, determines the fate.  Returns the exclude_list element which
  * matched, or NULL for undecided.
+ *
+ * Literal and suffix patterns are looked up by the basename first;
+ * only the remaining patterns that come after the best of those are
+ * then tried in turn.
  */
 static struct path_pattern *last_matching_pattern_from_list(const char *pathname,
 						       int pathlen,
@@ -1333,14 +1491,36 @@ static struct path_pattern *last_matching_pattern_from_list(const char *pathname
 						       struct pattern_list *pl,
 						       struct index_state *istate)
 {
-	struct path_pattern *res = NULL; /* undecided */
+	struct pattern_index_entry *e;
+	int basenamelen = pathlen - (basename - pathname);
+	int best = -1;
 	int i;
 
 	if (!pl->nr)
 		return NULL;	/* undefined */
 
-	for (i = pl->nr - 1; 0 <= i; i--) {
-		struct path_pattern *pattern = pl->patterns[i];
+	if (pl->indexed_nr != pl->nr)
+		index_patterns(pl);
+
+	e = pattern_index_get(&pl->basename_hashmap, basename, basenamelen);
+	if (e)
+		best = last_indexed_match(e, best, pathname, pathlen,
+					  dtype, pl, istate);
+	for (i = 0; i < pl->suffix_lens_nr; i++) {
+		int len = pl->suffix_lens[i];
+
+		if (basenamelen < len)
+			continue;
+		e = pattern_index_get(&pl->suffix_hashmap,
+				      basename + basenamelen - len, len);
+		if (e)
+			best = last_indexed_match(e, best, pathname, pathlen,
+						  dtype, pl, istate);
+	}
+
+	for (i = pl->other_patterns_nr - 1;
+	     0 <= i && best < pl->other_patterns[i]; i--) {
+		struct path_pattern *pattern = pl->patterns[pl->other_patterns[i]];
 		const char *exclude = pattern->pattern;
 		int prefix = pattern->nowildcardlen;
 
@@ -1351,13 +1531,10 @@ static struct path_pattern *last_matching_pattern_from_list(const char *pathname
 		}
 
 		if (pattern->flags & PATTERN_FLAG_NODIR) {
-			if (match_basename(basename,
-					   pathlen - (basename - pathname),
+			if (match_basename(basename, basenamelen,
 					   exclude, prefix, pattern->patternlen,
-					   pattern->flags)) {
-				res = pattern;
-				break;
-			}
+					   pattern->flags))
+				return pattern;
 			continue;
 		}
 
@@ -1366,12 +1543,10 @@ static struct path_pattern *last_matching_pattern_from_list(const char *pathname
 		if (match_pathname(pathname, pathlen,
 				   pattern->base,
 				   pattern->baselen ? pattern->baselen - 1 : 0,
-				   exclude, prefix, pattern->patternlen)) {
-			res = pattern;
-			break;
-		}
+				   exclude, prefix, pattern->patternlen))
+			return pattern;
 	}
-	return res;
+	return best < 0 ? NULL : pl->patterns[best];
 }
 
 /*
@@ -1834,6 +2009,14 @@ static enum exist_status directory_exists_in_index(struct index_state *istate,
 	return index_nonexistent;
 }
 
+/*
+ * While read_directory() scans subdirectories in parallel, the nested
+ * repository check in treat_directory() has to be serialized, as
+ * read_gitfile_gently() returns a static buffer.
+ */
+static int nested_repo_use_lock;
+static pthread_mutex_t nested_repo_mutex;
+
 /*
  * When we find a directory when traversing the filesystem, we
  * have three distinct cases:
@@ -1923,6 +2106,8 @@ static enum path_treatment treat_directory(struct dir_struct *dir,
 		int nested_repo;
 		struct strbuf sb = STRBUF_INIT;
 		strbuf_addstr(&sb, dirname);
+		if (nested_repo_use_lock)
+			pthread_mutex_lock(&nested_repo_mutex);
 		nested_repo = is_nonbare_repository_dir(&sb);
 
 		if (nested_repo) {
@@ -1935,6 +2120,8 @@ static enum path_treatment treat_directory(struct dir_struct *dir,
 			free(real_gitdir);
 			free(real_dirname);
 		}
+		if (nested_repo_use_lock)
+			pthread_mutex_unlock(&nested_repo_mutex);
 		strbuf_release(&sb);
 
 		if (nested_repo) {
@@ -2580,6 +2767,10 @@ static enum path_treatment read_directory_recursive(struct dir_struct *dir,
 	struct cached_dir cdir;
 	enum path_treatment state, subdir_state, dir_state = path_none;
 	struct strbuf path = STRBUF_INIT;
+	struct string_list *fan_out = dir->internal.fan_out;
+
+	/* only the outermost call hands its subdirectories out */
+	dir->internal.fan_out = NULL;
 
 	strbuf_add(&path, base, baselen);
 
@@ -2599,6 +2790,12 @@ static enum path_treatment read_directory_recursive(struct dir_struct *dir,
 		if (state > dir_state)
 			dir_state = state;
 
+		/* leave subdirs to the caller's threads if asked to */
+		if (state == path_recurse && fan_out) {
+			string_list_append(fan_out, path.buf);
+			continue;
+		}
+
 		/* recurse into subdir if instructed by treat_path */
 		if (state == path_recurse) {
 			struct untracked_cache_dir *ud;
@@ -3004,6 +3201,177 @@ static void emit_traversal_statistics(struct dir_struct *dir,
 			   "opendir", dir->untracked->dir_opened);
 }
 
+/*
+ * Cap the number of threads scanning subdirectories in parallel, and
+ * do not bother with threads unless there are at least this many
+ * subdirectories to hand out.
+ */
+#define MAX_SCAN_THREADS (16)
+#define MIN_SCAN_DIRS (2)
+
+struct scan_queue {
+	struct string_list *dirs;
+	size_t next;
+	pthread_mutex_t mutex;
+};
+
+struct scan_thread_data {
+	pthread_t pthread;
+	struct dir_struct dir;
+	struct index_state *istate;
+	struct pathspec pathspec;
+	const struct pathspec *pathspec_p;
+	struct scan_queue *queue;
+};
+
+static void *scan_thread(void *_data)
+{
+	struct scan_thread_data *p = _data;
+
+	trace2_thread_start("read_directory");
+	for (;;) {
+		const char *path;
+
+		pthread_mutex_lock(&p->queue->mutex);
+		if (p->queue->next >= p->queue->dirs->nr) {
+			pthread_mutex_unlock(&p->queue->mutex);
+			break;
+		}
+		path = p->queue->dirs->items[p->queue->next++].string;
+		pthread_mutex_unlock(&p->queue->mutex);
+
+		read_directory_recursive(&p->dir, p->istate, path, strlen(path),
+					 NULL, 0, 0, p->pathspec_p);
+	}
+	trace2_thread_exit();
+	return NULL;
+}
+
+static int scan_threads(struct index_state *istate)
+{
+	int threads;
+
+	if (!HAVE_THREADS || !core_preload_index || istate->sparse_index)
+		return 1;
+	threads = git_env_ulong("GIT_TEST_DIR_SCAN_THREADS", 0);
+	if (!threads)
+		threads = online_cpus();
+	return threads > MAX_SCAN_THREADS ? MAX_SCAN_THREADS : threads;
+}
+
+/*
+ * Without the untracked cache, which is updated in place as the walk
+ * goes, nothing under one subdirectory depends on what was found
+ * under its siblings: each only sees the .gitignore files of its own
+ * ancestors. Scan the top of the tree here, then let threads scan its
+ * subdirectories, each with its own dir_struct and exclude stack, and
+ * collect their results into "dir".
+ */
+static void read_directory_threaded(struct dir_struct *dir,
+				    struct index_state *istate,
+				    const char *path, int len,
+				    const struct pathspec *pathspec)
+{
+	struct string_list subdirs = STRING_LIST_INIT_DUP;
+	struct scan_thread_data *data;
+	struct scan_queue queue;
+	int threads = scan_threads(istate);
+	int had_obj_read_lock, i;
+
+	if (threads > 1)
+		dir->internal.fan_out = &subdirs;
+	read_directory_recursive(dir, istate, path, len, NULL, 0, 0, pathspec);
+	dir->internal.fan_out = NULL;
+
+	if (subdirs.nr < MIN_SCAN_DIRS) {
+		for (i = 0; i < subdirs.nr; i++)
+			read_directory_recursive(dir, istate, subdirs.items[i].string,
+						 strlen(subdirs.items[i].string),
+						 NULL, 0, 0, pathspec);
+		string_list_clear(&subdirs, 0);
+		return;
+	}
+	if (threads > subdirs.nr)
+		threads = subdirs.nr;
+
+	trace2_data_intmax("read_directory", istate->repo, "scan-threads", threads);
+
+	/*
+	 * Threads look up names in the index and may read .gitignore
+	 * blobs of skip-worktree paths from the object store.
+	 */
+	prepare_name_hash(istate);
+	had_obj_read_lock = obj_read_use_lock;
+	enable_obj_read_lock();
+	pthread_mutex_init(&nested_repo_mutex, NULL);
+	nested_repo_use_lock = 1;
+
+	queue.dirs = &subdirs;
+	queue.next = 0;
+	pthread_mutex_init(&queue.mutex, NULL);
+
+	CALLOC_ARRAY(data, threads);
+	for (i = 0; i < threads; i++) {
+		struct scan_thread_data *p = &data[i];
+		int err;
+
+		p->dir.flags = dir->flags;
+		p->dir.exclude_per_dir = dir->exclude_per_dir;
+		p->dir.internal.exclude_list_group[EXC_CMDL] =
+			dir->internal.exclude_list_group[EXC_CMDL];
+		p->dir.internal.exclude_list_group[EXC_FILE] =
+			dir->internal.exclude_list_group[EXC_FILE];
+		p->istate = istate;
+		if (pathspec) {
+			copy_pathspec(&p->pathspec, pathspec);
+			p->pathspec_p = &p->pathspec;
+		}
+		p->queue = &queue;
+
+		err = pthread_create(&p->pthread, NULL, scan_thread, p);
+		if (err)
+			die(_("unable to create threaded directory scan: %s"),
+			    strerror(err));
+	}
+
+	for (i = 0; i < threads; i++) {
+		struct scan_thread_data *p = &data[i];
+		int j;
+
+		if (pthread_join(p->pthread, NULL))
+			die(_("unable to join threaded directory scan"));
+
+		ALLOC_GROW(dir->entries, dir->nr + p->dir.nr, dir->internal.alloc);
+		for (j = 0; j < p->dir.nr; j++)
+			dir->entries[dir->nr++] = p->dir.entries[j];
+		ALLOC_GROW(dir->ignored, dir->ignored_nr + p->dir.ignored_nr,
+			   dir->internal.ignored_alloc);
+		for (j = 0; j < p->dir.ignored_nr; j++)
+			dir->ignored[dir->ignored_nr++] = p->dir.ignored[j];
+		dir->internal.visited_paths += p->dir.internal.visited_paths;
+		dir->internal.visited_directories +=
+			p->dir.internal.visited_directories;
+
+		/* the entries moved, and the shared lists belong to "dir" */
+		p->dir.nr = p->dir.ignored_nr = 0;
+		memset(&p->dir.internal.exclude_list_group[EXC_CMDL], 0,
+		       sizeof(p->dir.internal.exclude_list_group[EXC_CMDL]));
+		memset(&p->dir.internal.exclude_list_group[EXC_FILE], 0,
+		       sizeof(p->dir.internal.exclude_list_group[EXC_FILE]));
+		dir_clear(&p->dir);
+		if (pathspec)
+			clear_pathspec(&p->pathspec);
+	}
+	free(data);
+
+	nested_repo_use_lock = 0;
+	pthread_mutex_destroy(&nested_repo_mutex);
+	pthread_mutex_destroy(&queue.mutex);
+	if (!had_obj_read_lock)
+		disable_obj_read_lock();
+	string_list_clear(&subdirs, 0);
+}
+
 int read_directory(struct dir_struct *dir, struct index_state *istate,
 		   const char *path, int len, const struct pathspec *pathspec)
 {
@@ -3025,8 +3393,13 @@ int read_directory(struct dir_struct *dir, struct index_state *istate,
 		 * e.g. prep_exclude()
 		 */
 		dir->untracked = NULL;
-	if (!len || treat_leading_path(dir, istate, path, len, pathspec))
-		read_directory_recursive(dir, istate, path, len, untracked, 0, 0, pathspec);
+	if (!len || treat_leading_path(dir, istate, path, len, pathspec)) {
+		if (untracked)
+			read_directory_recursive(dir, istate, path, len,
+						 untracked, 0, 0, pathspec);
+		else
+			read_directory_threaded(dir, istate, path, len, pathspec);
+	}
 	QSORT(dir->entries, dir->nr, cmp_dir_entry);
 	QSORT(dir->ignored, dir->ignored_nr, cmp_dir_entry);
 
@@ -8,6 +8,7 @@
 #include "strbuf.h"
 
 struct repository;
+struct string_list;
 
 /**
  * The directory listing API is used to enumerate paths in the work tree,
@@ -121,6 +122,22 @@ struct pattern_list {
 	 * Used to check single-level parents of blobs.
 	 */
 	struct hashmap parent_hashmap;
+
+	/*
+	 * Patterns that can only match a basename literally ("foo") or by
+	 * a literal suffix ("*.o") are indexed by that string, so that
+	 * last_matching_pattern_from_list() only has to try the remaining
+	 * ones one by one. The first "indexed_nr" patterns are indexed,
+	 * and "other_patterns" holds the positions of those that are in
+	 * neither hashmap, in increasing order.
+	 */
+	int indexed_nr;
+	struct hashmap basename_hashmap;
+	struct hashmap suffix_hashmap;
+	int *suffix_lens;
+	int suffix_lens_nr, suffix_lens_alloc;
+	int *other_patterns;
+	int other_patterns_nr, other_patterns_alloc;
 };
 
 /*
@@ -348,6 +365,13 @@ struct dir_struct {
 		struct path_pattern *pattern;
 		struct strbuf basebuf;
 
+		/*
+		 * If set, the outermost read_directory_recursive() call
+		 * queues the subdirectories it would recurse into here
+		 * instead, so that they can be scanned in parallel.
+		 */
+		struct string_list *fan_out;
+
 		/* Additional metadata related to 'untracked' */
 		struct oid_stat ss_info_exclude;
 		struct oid_stat ss_excludes_file;
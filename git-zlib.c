@@ -5,6 +5,10 @@
 #include "git-compat-util.h"
 #include "git-zlib.h"
 
+#ifdef USE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
 static const char *zerr_to_string(int status)
 {
 	switch (status) {
@@ -272,3 +276,62 @@ int git_deflate(git_zstream *strm, int flush)
 	      strm->z.msg ? strm->z.msg : "no message");
 	return status;
 }
+
+int git_inflate_whole(void *out, unsigned long out_len,
+		      const void *in, unsigned long in_len)
+{
+#ifdef USE_LIBDEFLATE
+	struct libdeflate_decompressor *d;
+	enum libdeflate_result res;
+	size_t used;
+
+	/*
+	 * A decompressor is cheap to allocate, and having one per call
+	 * keeps us safe for callers that inflate outside of the object
+	 * read lock.
+	 */
+	d = libdeflate_alloc_decompressor();
+	if (!d)
+		die("libdeflate: out of memory");
+	/*
+	 * Passing "used" lets the stream be followed by unrelated data
+	 * (e.g. the next object in a pack), and a NULL actual_out asks
+	 * for exactly out_len bytes of output.
+	 */
+	res = libdeflate_zlib_decompress_ex(d, in, in_len, out, out_len,
+					    &used, NULL);
+	libdeflate_free_decompressor(d);
+	return res == LIBDEFLATE_SUCCESS ? 0 : -1;
+#else
+	return -1;
+#endif
+}
+
+void *git_deflate_whole(const void *in, unsigned long in_len,
+			int level, unsigned long *out_len)
+{
+#ifdef USE_LIBDEFLATE
+	struct libdeflate_compressor *c;
+	size_t bound, len;
+	void *out;
+
+	/* libdeflate levels 0..9 match zlib's; it has no "default" */
+	if (level == Z_DEFAULT_COMPRESSION)
+		level = 6;
+	c = libdeflate_alloc_compressor(level);
+	if (!c)
+		return NULL;
+	bound = libdeflate_zlib_compress_bound(c, in_len);
+	out = xmalloc(bound);
+	len = libdeflate_zlib_compress(c, in, in_len, out, bound);
+	libdeflate_free_compressor(c);
+	if (!len) {
+		free(out);
+		return NULL;
+	}
+	*out_len = len;
+	return out;
+#else
+	return NULL;
+#endif
+}
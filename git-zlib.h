@@ -25,4 +25,26 @@ int git_deflate_end_gently(git_zstream *);
 int git_deflate(git_zstream *, int flush);
 unsigned long git_deflate_bound(git_zstream *, unsigned long);
 
+/*
+ * Whole-buffer helpers for callers that already know the size of the
+ * uncompressed data. When built with USE_LIBDEFLATE these are served by
+ * libdeflate, which is much faster than zlib's streaming interface;
+ * otherwise they decline and the caller uses git_zstream as usual.
+ *
+ * git_inflate_whole() inflates a zlib stream starting at "in" (of which
+ * at most "in_len" bytes are available) into exactly "out_len" bytes at
+ * "out". It returns 0 on success, or -1 if the stream could not be
+ * inflated that way (e.g. it is not complete within "in_len", does not
+ * produce exactly "out_len" bytes, or is corrupt), in which case the
+ * caller should fall back to git_inflate() for proper diagnosis.
+ *
+ * git_deflate_whole() compresses "in_len" bytes at "in" into a newly
+ * allocated buffer, stores its size in "out_len" and returns it, or
+ * returns NULL if the caller should fall back to git_deflate().
+ */
+int git_inflate_whole(void *out, unsigned long out_len,
+		      const void *in, unsigned long in_len);
+void *git_deflate_whole(const void *in, unsigned long in_len,
+			int level, unsigned long *out_len);
+
 #endif /* GIT_ZLIB_H */
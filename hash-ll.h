@@ -11,6 +11,14 @@
 #include "block-sha1/sha1.h"
 #endif
 
+#if defined(SHA1_OPENSSL_UNSAFE)
+#include <openssl/sha.h>
+#define platform_SHA_CTX_unsafe		SHA_CTX
+#define platform_SHA1_Init_unsafe	SHA1_Init
+#define platform_SHA1_Update_unsafe	SHA1_Update
+#define platform_SHA1_Final_unsafe	SHA1_Final
+#endif
+
 #if defined(SHA256_NETTLE)
 #include "sha256/nettle.h"
 #elif defined(SHA256_GCRYPT)
@@ -41,6 +49,24 @@
 #define git_SHA1_Update		platform_SHA1_Update
 #define git_SHA1_Final		platform_SHA1_Final
 
+/*
+ * The "unsafe" SHA-1 is used where the hash only guards against
+ * accidental corruption, like the trailing checksum of a packfile or
+ * the index, and never names an object. Unless a separate backend was
+ * picked for it, it is the same as the one above.
+ */
+#ifdef platform_SHA_CTX_unsafe
+#define git_SHA_CTX_unsafe	platform_SHA_CTX_unsafe
+#define git_SHA1_Init_unsafe	platform_SHA1_Init_unsafe
+#define git_SHA1_Update_unsafe	platform_SHA1_Update_unsafe
+#define git_SHA1_Final_unsafe	platform_SHA1_Final_unsafe
+#else
+#define git_SHA_CTX_unsafe	git_SHA_CTX
+#define git_SHA1_Init_unsafe	git_SHA1_Init
+#define git_SHA1_Update_unsafe	git_SHA1_Update
+#define git_SHA1_Final_unsafe	git_SHA1_Final
+#endif
+
 #ifndef platform_SHA256_CTX
 #define platform_SHA256_CTX	SHA256_CTX
 #define platform_SHA256_Init	SHA256_Init
@@ -68,6 +94,12 @@ static inline void git_SHA1_Clone(git_SHA_CTX *dst, const git_SHA_CTX *src)
 	memcpy(dst, src, sizeof(*dst));
 }
 
+static inline void git_SHA1_Clone_unsafe(git_SHA_CTX_unsafe *dst,
+					 const git_SHA_CTX_unsafe *src)
+{
+	memcpy(dst, src, sizeof(*dst));
+}
+
 #ifndef SHA256_NEEDS_CLONE_HELPER
 static inline void git_SHA256_Clone(git_SHA256_CTX *dst, const git_SHA256_CTX *src)
 {
@@ -158,6 +190,7 @@ enum get_oid_result {
 /* A suitably aligned type for stack allocations of hash contexts. */
 union git_hash_ctx {
 	git_SHA_CTX sha1;
+	git_SHA_CTX_unsafe sha1_unsafe;
 	git_SHA256_CTX sha256;
 };
 typedef union git_hash_ctx git_hash_ctx;
@@ -202,6 +235,15 @@ struct git_hash_algo {
 	/* The hash finalization function for object IDs. */
 	git_hash_final_oid_fn final_oid_fn;
 
+	/*
+	 * The same, for checksums that never name an object. These may
+	 * use a faster implementation without collision detection.
+	 */
+	git_hash_init_fn unsafe_init_fn;
+	git_hash_clone_fn unsafe_clone_fn;
+	git_hash_update_fn unsafe_update_fn;
+	git_hash_final_fn unsafe_final_fn;
+
 	/* The OID of the empty tree. */
 	const struct object_id *empty_tree;
 
@@ -19,6 +19,8 @@
 #include "setup.h"
 #include "strvec.h"
 #include "bloom.h"
+#include "strmap.h"
+#include "trace2.h"
 #include "tree-walk.h"
 
 static void range_set_grow(struct range_set *rs, size_t extra)
@@ -1149,12 +1151,55 @@ int line_log_print(struct rev_info *rev, struct commit *commit)
 	return 1;
 }
 
+static int bloom_filter_atexit_registered;
+static unsigned int count_bloom_filter_maybe;
+static unsigned int count_bloom_filter_definitely_not;
+
+static void trace2_bloom_filter_statistics_atexit(void)
+{
+	trace2_data_intmax("line-log", the_repository, "bloom/maybe",
+			   count_bloom_filter_maybe);
+	trace2_data_intmax("line-log", the_repository, "bloom/definitely_not",
+			   count_bloom_filter_definitely_not);
+}
+
+static struct bloom_keyvec *get_bloom_keyvec(struct rev_info *rev,
+					      const char *path)
+{
+	struct bloom_keyvec *vec;
+
+	if (!rev->line_log_bloom_keys) {
+		CALLOC_ARRAY(rev->line_log_bloom_keys, 1);
+		strmap_init(rev->line_log_bloom_keys);
+	}
+	vec = strmap_get(rev->line_log_bloom_keys, path);
+	if (!vec) {
+		CALLOC_ARRAY(vec, 1);
+		fill_bloom_keyvec(vec, path, strlen(path),
+				  rev->bloom_filter_settings);
+		strmap_put(rev->line_log_bloom_keys, path, vec);
+	}
+	return vec;
+}
+
+void line_log_release_bloom_keys(struct rev_info *rev)
+{
+	struct hashmap_iter iter;
+	struct strmap_entry *e;
+
+	if (!rev->line_log_bloom_keys)
+		return;
+	strmap_for_each_entry(rev->line_log_bloom_keys, &iter, e)
+		clear_bloom_keyvec(e->value);
+	strmap_clear(rev->line_log_bloom_keys, 1);
+	FREE_AND_NULL(rev->line_log_bloom_keys);
+}
+
 static int bloom_filter_check(struct rev_info *rev,
 			      struct commit *commit,
 			      struct line_log_data *range)
 {
 	struct bloom_filter *filter;
-	struct bloom_key key;
 	int result = 0;
 
 	if (!commit->parents)
@@ -1167,17 +1212,26 @@ static int bloom_filter_check(struct rev_info *rev,
 	if (!range)
 		return 0;
 
-	while (!result && range) {
-		fill_bloom_key(range->path, strlen(range->path), &key, rev->bloom_filter_settings);
+	if (trace2_is_enabled() && !bloom_filter_atexit_registered) {
+		atexit(trace2_bloom_filter_statistics_atexit);
+		bloom_filter_atexit_registered = 1;
+	}
 
-		if (bloom_filter_contains(filter, &key, rev->bloom_filter_settings))
-			result = 1;
+	while (!result && range) {
+		struct bloom_keyvec *vec =
+			get_bloom_keyvec(rev, range->path);
 
-		clear_bloom_key(&key);
+		result = bloom_filter_contains_vec(filter, vec,
+						   rev->bloom_filter_settings);
 		range = range->next;
 	}
 
-	return result;
+	if (result)
+		count_bloom_filter_maybe++;
+	else
+		count_bloom_filter_definitely_not++;
+
+	return !!result;
 }
 
 static int process_ranges_ordinary_commit(struct rev_info *rev, struct commit *commit,
@@ -60,4 +60,6 @@ int line_log_process_ranges_arbitrary_commit(struct rev_info *rev,
 
 int line_log_print(struct rev_info *rev, struct commit *commit);
 
+void line_log_release_bloom_keys(struct rev_info *rev);
+
 #endif /* LINE_LOG_H */
@@ -126,6 +126,61 @@ static void hash_index_entry(struct index_state *istate, struct cache_entry *ce)
 		add_dir_entry(istate, ce);
 }
 
+/*
+ * Hash every entry of the index in one go. The entries are sorted, so
+ * runs of them share a leading directory: remember the directory of
+ * the previous entry and, as long as it does not change, skip looking
+ * it up and only hash what follows it, continuing from the hash of
+ * the directory (which is how the threaded code computes it, too).
+ */
+static void hash_all_index_entries(struct index_state *istate)
+{
+	struct dir_entry *dir = NULL;
+	const char *prefix = NULL;
+	unsigned int prefix_hash = 0;
+	int prefixlen = 0;
+	int nr;
+
+	for (nr = 0; nr < istate->cache_nr; nr++) {
+		struct cache_entry *ce = istate->cache[nr];
+		int namelen = ce_namelen(ce);
+		int len = namelen;
+
+		if (ce->ce_flags & CE_HASHED)
+			continue;
+		ce->ce_flags |= CE_HASHED;
+
+		/* length of the leading directory, without its slash */
+		while (len > 0 && !is_dir_sep(ce->name[len - 1]))
+			len--;
+		if (len > 0)
+			len--;
+
+		if (!prefix || len != prefixlen || memcmp(prefix, ce->name, len)) {
+			prefix = ce->name;
+			prefixlen = len;
+			prefix_hash = len ? memihash(ce->name, len) : 0;
+			dir = ignore_case ? hash_dir_entry(istate, ce, namelen) : NULL;
+		}
+
+		if (!S_ISSPARSEDIR(ce->ce_mode)) {
+			unsigned int hash = len ?
+				memihash_cont(prefix_hash, ce->name + len, namelen - len) :
+				memihash(ce->name, namelen);
+
+			hashmap_entry_init(&ce->ent, hash);
+			hashmap_add(&istate->name_hash, &ce->ent);
+		}
+
+		if (ignore_case) {
+			struct dir_entry *d = dir;
+
+			while (d && !(d->nr++))
+				d = d->parent;
+		}
+	}
+}
+
 static int cache_entry_cmp(const void *cmp_data UNUSED,
 			   const struct hashmap_entry *eptr,
 			   const struct hashmap_entry *entry_or_key,
@@ -603,9 +658,7 @@ static void lazy_init_name_hash(struct index_state *istate)
 		threaded_lazy_init_name_hash(istate);
 		hashmap_enable_item_counting(&istate->dir_hash);
 	} else {
-		int nr;
-		for (nr = 0; nr < istate->cache_nr; nr++)
-			hash_index_entry(istate, istate->cache[nr]);
+		hash_all_index_entries(istate);
 	}
 
 	istate->name_hash_initialized = 1;
@@ -632,6 +685,11 @@ int test_lazy_init_name_hash(struct index_state *istate, int try_threaded)
 	return lazy_nr_dir_threads;
 }
 
+void prepare_name_hash(struct index_state *istate)
+{
+	lazy_init_name_hash(istate);
+}
+
 void add_name_hash(struct index_state *istate, struct cache_entry *ce)
 {
 	if (istate->name_hash_initialized)
@@ -9,6 +9,12 @@ void adjust_dirname_case(struct index_state *istate, char *name);
 struct cache_entry *index_file_exists(struct index_state *istate, const char *name, int namelen, int igncase);
 
 int test_lazy_init_name_hash(struct index_state *istate, int try_threaded);
+
+/*
+ * Build the name hash now rather than on the first lookup, e.g. before
+ * several threads look up names in the same index.
+ */
+void prepare_name_hash(struct index_state *istate);
 void add_name_hash(struct index_state *istate, struct cache_entry *ce);
 void remove_name_hash(struct index_state *istate, struct cache_entry *ce);
 void free_name_hash(struct index_state *istate);
@@ -1,5 +1,7 @@
 #include "git-compat-util.h"
+#include "config.h"
 #include "environment.h"
+#include "gettext.h"
 #include "hex.h"
 #include "repository.h"
 #include "pack.h"
@@ -8,6 +10,8 @@
 #include "packfile.h"
 #include "object-file.h"
 #include "object-store-ll.h"
+#include "thread-utils.h"
+#include "trace2.h"
 
 struct idx_entry {
 	off_t                offset;
@@ -47,6 +51,129 @@ int check_pack_crc(struct packed_git *p, struct pack_window **w_curs,
 	return data_crc != ntohl(*index_crc);
 }
 
+/*
+ * The result of unpacking and hashing one object, handed from the
+ * thread that did the work back to the one reporting it.
+ */
+struct verify_result {
+	struct object_id oid;
+	void *data;
+	enum object_type type;
+	unsigned long size;
+	unsigned data_valid:1,
+		 crc_mismatch:1,
+		 signature_mismatch:1,
+		 done:1;
+};
+
+struct verify_pack_data {
+	struct repository *r;
+	struct packed_git *p;
+	struct idx_entry *entries;
+	uint32_t nr_objects;
+
+	/*
+	 * Objects are handed out in pack order; at most "window" of
+	 * them may be unpacked ahead of the one being reported.
+	 */
+	struct verify_result *results;
+	uint32_t window;
+	uint32_t next;
+	uint32_t consumed;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+};
+
+static void verify_one(struct verify_pack_data *d, uint32_t i,
+		       struct pack_window **w_curs)
+{
+	struct packed_git *p = d->p;
+	struct idx_entry *entry = &d->entries[i];
+	struct verify_result *res = &d->results[i % d->window];
+	off_t curpos;
+
+	if (nth_packed_object_id(&res->oid, p, entry->nr) < 0)
+		BUG("unable to get oid of object %lu from %s",
+		    (unsigned long)entry->nr, p->pack_name);
+
+	obj_read_lock();
+	res->crc_mismatch = 0;
+	if (p->index_version > 1) {
+		off_t len = entry[1].offset - entry->offset;
+		if (check_pack_crc(p, w_curs, entry->offset, len, entry->nr))
+			res->crc_mismatch = 1;
+	}
+
+	curpos = entry->offset;
+	res->type = unpack_object_header(p, w_curs, &curpos, &res->size);
+	unuse_pack(w_curs);
+
+	if (res->type == OBJ_BLOB && big_file_threshold <= res->size) {
+		/*
+		 * Let stream_object_signature() check it with
+		 * the streaming interface; no point slurping
+		 * the data in-core only to discard.
+		 */
+		res->data = NULL;
+		res->data_valid = 0;
+	} else {
+		res->data = unpack_entry(d->r, p, entry->offset,
+					 &res->type, &res->size);
+		res->data_valid = 1;
+	}
+	obj_read_unlock();
+
+	/* hashing is the expensive part, and needs no lock */
+	res->signature_mismatch = res->data &&
+		check_object_signature(d->r, &res->oid, res->data,
+				       res->size, res->type) < 0;
+}
+
+static void *verify_thread(void *data)
+{
+	struct verify_pack_data *d = data;
+	struct pack_window *w_curs = NULL;
+
+	for (;;) {
+		uint32_t i;
+
+		pthread_mutex_lock(&d->mutex);
+		while (d->next < d->nr_objects &&
+		       d->next >= d->consumed + d->window)
+			pthread_cond_wait(&d->cond, &d->mutex);
+		if (d->next >= d->nr_objects) {
+			pthread_mutex_unlock(&d->mutex);
+			break;
+		}
+		i = d->next++;
+		pthread_mutex_unlock(&d->mutex);
+
+		verify_one(d, i, &w_curs);
+
+		pthread_mutex_lock(&d->mutex);
+		d->results[i % d->window].done = 1;
+		pthread_cond_broadcast(&d->cond);
+		pthread_mutex_unlock(&d->mutex);
+	}
+
+	obj_read_lock();
+	unuse_pack(&w_curs);
+	obj_read_unlock();
+	return NULL;
+}
+
+static int verify_pack_threads(struct repository *r)
+{
+	int nr_threads;
+
+	if (!HAVE_THREADS)
+		return 1;
+	if (repo_config_get_int(r, "pack.threads", &nr_threads) ||
+	    nr_threads <= 0)
+		nr_threads = online_cpus();
+	return nr_threads;
+}
+
 static int verify_packfile(struct repository *r,
 			   struct packed_git *p,
 			   struct pack_window **w_curs,
@@ -62,11 +189,15 @@ static int verify_packfile(struct repository *r,
 	uint32_t nr_objects, i;
 	int err = 0;
 	struct idx_entry *entries;
+	struct verify_pack_data d = { 0 };
+	pthread_t *threads = NULL;
+	int nr_threads, lock_enabled = 0;
 
 	if (!is_pack_valid(p))
 		return error("packfile %s cannot be accessed", p->pack_name);
 
-	r->hash_algo->init_fn(&ctx);
+	trace2_region_enter("pack-check", "checksum", r);
+	r->hash_algo->unsafe_init_fn(&ctx);
 	do {
 		unsigned long remaining;
 		unsigned char *in = use_pack(p, w_curs, offset, &remaining);
@@ -75,9 +206,9 @@ static int verify_packfile(struct repository *r,
 			pack_sig_ofs = p->pack_size - r->hash_algo->rawsz;
 		if (offset > pack_sig_ofs)
 			remaining -= (unsigned int)(offset - pack_sig_ofs);
-		r->hash_algo->update_fn(&ctx, in, remaining);
+		r->hash_algo->unsafe_update_fn(&ctx, in, remaining);
 	} while (offset < pack_sig_ofs);
-	r->hash_algo->final_fn(hash, &ctx);
+	r->hash_algo->unsafe_final_fn(hash, &ctx);
 	pack_sig = use_pack(p, w_curs, pack_sig_ofs, NULL);
 	if (!hasheq(hash, pack_sig))
 		err = error("%s pack checksum mismatch",
@@ -86,6 +217,8 @@ static int verify_packfile(struct repository *r,
 		err = error("%s pack checksum does not match its index",
 			    p->pack_name);
 	unuse_pack(w_curs);
+	trace2_data_intmax("pack-check", r, "checksum/bytes", p->pack_size);
+	trace2_region_leave("pack-check", "checksum", r);
 
 	/* Make sure everything reachable from idx is valid.  Since we
 	 * have verified that nr_objects matches between idx and pack,
@@ -101,69 +234,108 @@ static int verify_packfile(struct repository *r,
 	}
 	QSORT(entries, nr_objects, compare_entries);
 
-	for (i = 0; i < nr_objects; i++) {
-		void *data;
-		struct object_id oid;
-		enum object_type type;
-		unsigned long size;
-		off_t curpos;
-		int data_valid;
-
-		if (nth_packed_object_id(&oid, p, entries[i].nr) < 0)
-			BUG("unable to get oid of object %lu from %s",
-			    (unsigned long)entries[i].nr, p->pack_name);
-
-		if (p->index_version > 1) {
-			off_t offset = entries[i].offset;
-			off_t len = entries[i+1].offset - offset;
-			unsigned int nr = entries[i].nr;
-			if (check_pack_crc(p, w_curs, offset, len, nr))
-				err = error("index CRC mismatch for object %s "
-					    "from %s at offset %"PRIuMAX"",
-					    oid_to_hex(&oid),
-					    p->pack_name, (uintmax_t)offset);
+	/*
+	 * Unpacking and hashing the objects can be spread over threads,
+	 * but they are reported (and handed to "fn") one by one in pack
+	 * order from this thread, so that the output stays the same.
+	 */
+	nr_threads = verify_pack_threads(r);
+	if (nr_threads > nr_objects)
+		nr_threads = nr_objects;
+	d.r = r;
+	d.p = p;
+	d.entries = entries;
+	d.nr_objects = nr_objects;
+	d.window = nr_threads > 1 ? nr_threads * 4 : 1;
+	CALLOC_ARRAY(d.results, d.window);
+
+	trace2_region_enter("pack-check", "objects", r);
+	if (nr_threads > 1) {
+		if (!obj_read_use_lock) {
+			enable_obj_read_lock();
+			lock_enabled = 1;
+		}
+		pthread_mutex_init(&d.mutex, NULL);
+		pthread_cond_init(&d.cond, NULL);
+		CALLOC_ARRAY(threads, nr_threads);
+		for (i = 0; i < nr_threads; i++) {
+			int ret = pthread_create(&threads[i], NULL,
+						 verify_thread, &d);
+			if (ret)
+				die(_("unable to create thread: %s"),
+				    strerror(ret));
 		}
+	}
+
+	for (i = 0; i < nr_objects; i++) {
+		struct verify_result *res = &d.results[i % d.window];
 
-		curpos = entries[i].offset;
-		type = unpack_object_header(p, w_curs, &curpos, &size);
-		unuse_pack(w_curs);
-
-		if (type == OBJ_BLOB && big_file_threshold <= size) {
-			/*
-			 * Let stream_object_signature() check it with
-			 * the streaming interface; no point slurping
-			 * the data in-core only to discard.
-			 */
-			data = NULL;
-			data_valid = 0;
+		if (threads) {
+			pthread_mutex_lock(&d.mutex);
+			while (!res->done)
+				pthread_cond_wait(&d.cond, &d.mutex);
+			pthread_mutex_unlock(&d.mutex);
 		} else {
-			data = unpack_entry(r, p, entries[i].offset, &type, &size);
-			data_valid = 1;
+			verify_one(&d, i, w_curs);
 		}
 
-		if (data_valid && !data)
+		if (res->crc_mismatch)
+			err = error("index CRC mismatch for object %s "
+				    "from %s at offset %"PRIuMAX"",
+				    oid_to_hex(&res->oid),
+				    p->pack_name, (uintmax_t)entries[i].offset);
+
+		/*
+		 * The workers may still be reading from the pack, and
+		 * neither the streaming interface nor "fn" expect that.
+		 */
+		obj_read_lock();
+		if (res->data_valid && !res->data)
 			err = error("cannot unpack %s from %s at offset %"PRIuMAX"",
-				    oid_to_hex(&oid), p->pack_name,
+				    oid_to_hex(&res->oid), p->pack_name,
 				    (uintmax_t)entries[i].offset);
-		else if (data && check_object_signature(r, &oid, data, size,
-							type) < 0)
+		else if (res->signature_mismatch)
 			err = error("packed %s from %s is corrupt",
-				    oid_to_hex(&oid), p->pack_name);
-		else if (!data && stream_object_signature(r, &oid) < 0)
+				    oid_to_hex(&res->oid), p->pack_name);
+		else if (!res->data && stream_object_signature(r, &res->oid) < 0)
 			err = error("packed %s from %s is corrupt",
-				    oid_to_hex(&oid), p->pack_name);
+				    oid_to_hex(&res->oid), p->pack_name);
 		else if (fn) {
 			int eaten = 0;
-			err |= fn(&oid, type, size, data, &eaten);
+			err |= fn(&res->oid, res->type, res->size, res->data,
+				  &eaten);
 			if (eaten)
-				data = NULL;
+				res->data = NULL;
 		}
+		obj_read_unlock();
 		if (((base_count + i) & 1023) == 0)
 			display_progress(progress, base_count + i);
-		free(data);
+		FREE_AND_NULL(res->data);
 
+		if (threads) {
+			pthread_mutex_lock(&d.mutex);
+			res->done = 0;
+			d.consumed = i + 1;
+			pthread_cond_broadcast(&d.cond);
+			pthread_mutex_unlock(&d.mutex);
+		}
 	}
 	display_progress(progress, base_count + i);
+
+	if (threads) {
+		for (i = 0; i < nr_threads; i++)
+			pthread_join(threads[i], NULL);
+		free(threads);
+		pthread_cond_destroy(&d.cond);
+		pthread_mutex_destroy(&d.mutex);
+		if (lock_enabled)
+			disable_obj_read_lock();
+	}
+	trace2_data_intmax("pack-check", r, "objects/count", nr_objects);
+	trace2_data_intmax("pack-check", r, "objects/threads", nr_threads);
+	trace2_region_leave("pack-check", "objects", r);
+
+	free(d.results);
 	free(entries);
 
 	return err;
@@ -1615,10 +1615,24 @@ static void *unpack_compressed_entry(struct packed_git *p,
 	int st;
 	git_zstream stream;
 	unsigned char *buffer, *in;
+	unsigned long avail;
 
 	buffer = xmallocz_gently(size);
 	if (!buffer)
 		return NULL;
+
+	/*
+	 * Try to inflate the whole object in one go if it is entirely
+	 * within the current window; the streaming loop below deals with
+	 * everything else, including reporting corruption.
+	 */
+	in = use_pack(p, w_curs, curpos, &avail);
+	obj_read_unlock();
+	st = git_inflate_whole(buffer, size, in, avail);
+	obj_read_lock();
+	if (!st)
+		return buffer;
+
 	memset(&stream, 0, sizeof(stream));
 	stream.next_out = buffer;
 	stream.avail_out = size + 1;
@@ -2,12 +2,16 @@
  * Copyright (C) 2008 Linus Torvalds
  */
 #include "git-compat-util.h"
+#include "alloc.h"
 #include "pathspec.h"
 #include "dir.h"
 #include "environment.h"
 #include "fsmonitor.h"
 #include "gettext.h"
+#include "hash.h"
 #include "config.h"
+#include "convert.h"
+#include "object-file.h"
 #include "preload-index.h"
 #include "progress.h"
 #include "read-cache.h"
@@ -38,8 +42,28 @@ struct thread_data {
 	struct progress_data *progress;
 	int offset, nr;
 	int t2_nr_lstat;
+	struct cache_entry **racy;
+	int racy_nr, racy_alloc;
 };
 
+/*
+ * An entry whose stat data matches the file exactly but whose mtime
+ * is too close to that of the index cannot be trusted without looking
+ * at its contents. Such entries are common right after a large
+ * checkout; collect them so that their contents can be hashed in
+ * parallel instead of one by one in refresh_index().
+ */
+static int is_racy_only(struct index_state *index, struct cache_entry *ce,
+			struct stat *st, unsigned int changed)
+{
+	return changed == DATA_CHANGED &&
+		S_ISREG(ce->ce_mode) && S_ISREG(st->st_mode) &&
+		is_racy_timestamp(index, ce) &&
+		ce->ce_stat_data.sd_size &&
+		ce->ce_stat_data.sd_size == (unsigned int)st->st_size &&
+		st->st_size <= big_file_threshold;
+}
+
 static void *preload_thread(void *_data)
 {
 	int nr, last_nr;
@@ -51,11 +75,16 @@ static void *preload_thread(void *_data)
 	nr = p->nr;
 	if (nr + p->offset > index->cache_nr)
 		nr = index->cache_nr - p->offset;
+	if (nr <= 0)
+		return NULL;
 	last_nr = nr;
 
+	trace2_thread_start("preload_thread");
+
 	do {
 		struct cache_entry *ce = *cep++;
 		struct stat st;
+		unsigned int changed;
 
 		if (ce_stage(ce))
 			continue;
@@ -83,8 +112,14 @@ static void *preload_thread(void *_data)
 		p->t2_nr_lstat++;
 		if (lstat(ce->name, &st))
 			continue;
-		if (ie_match_stat(index, ce, &st, CE_MATCH_RACY_IS_DIRTY|CE_MATCH_IGNORE_FSMONITOR))
+		changed = ie_match_stat(index, ce, &st, CE_MATCH_RACY_IS_DIRTY|CE_MATCH_IGNORE_FSMONITOR);
+		if (changed) {
+			if (is_racy_only(index, ce, &st, changed)) {
+				ALLOC_GROW(p->racy, p->racy_nr + 1, p->racy_alloc);
+				p->racy[p->racy_nr++] = ce;
+			}
 			continue;
+		}
 		ce_mark_uptodate(ce);
 		mark_fsmonitor_valid(index, ce);
 	} while (--nr > 0);
@@ -96,9 +131,159 @@ static void *preload_thread(void *_data)
 		pthread_mutex_unlock(&pd->mutex);
 	}
 	cache_def_clear(&cache);
+	trace2_data_intmax("index", NULL, "preload/thread_lstat", p->t2_nr_lstat);
+	trace2_thread_exit();
+	return NULL;
+}
+
+struct racy_data {
+	pthread_t pthread;
+	struct index_state *index;
+	struct cache_entry **racy;
+	int nr;
+	int t2_nr_verified;
+};
+
+static void *verify_racy_thread(void *_data)
+{
+	struct racy_data *p = _data;
+	int i;
+
+	trace2_thread_start("preload_racy");
+	for (i = 0; i < p->nr; i++) {
+		struct cache_entry *ce = p->racy[i];
+		struct object_id oid;
+		struct stat st;
+		int fd;
+
+		fd = git_open_cloexec(ce->name, O_RDONLY);
+		if (fd < 0)
+			continue;
+		/*
+		 * The caller made sure no conversion applies to this path,
+		 * so hash the contents as they are; this keeps the
+		 * attribute machinery, which is not thread-safe, out of
+		 * the worker threads.
+		 */
+		if (fstat(fd, &st) ||
+		    (unsigned int)st.st_size != ce->ce_stat_data.sd_size) {
+			close(fd);
+			continue;
+		}
+		if (index_fd(p->index, &oid, fd, &st, OBJ_BLOB, NULL, 0))
+			continue;
+		/* index_fd() closed the file descriptor already */
+		if (!oideq(&oid, &ce->oid))
+			continue;
+		ce_mark_uptodate(ce);
+		mark_fsmonitor_valid(p->index, ce);
+		p->t2_nr_verified++;
+	}
+	trace2_data_intmax("index", NULL, "preload/thread_racy_verified",
+			   p->t2_nr_verified);
+	trace2_thread_exit();
 	return NULL;
 }
 
+/*
+ * Hash the contents of the racily clean entries collected by the
+ * lstat threads, and mark those that turn out to be unchanged as up
+ * to date, so that refresh_index() does not have to look at them
+ * again one at a time. Entries whose contents would go through a
+ * conversion (eol, ident, clean filters, working tree encoding) are
+ * left for the serial code path.
+ */
+static void verify_racy_entries(struct index_state *index,
+				struct thread_data *data, int threads)
+{
+	struct cache_entry **racy = NULL;
+	int nr = 0, alloc = 0;
+	struct racy_data rdata[MAX_PARALLEL];
+	int i, work, t2_sum_verified = 0;
+
+	for (i = 0; i < threads; i++) {
+		struct thread_data *p = data + i;
+		int j;
+
+		for (j = 0; j < p->racy_nr; j++) {
+			struct cache_entry *ce = p->racy[j];
+
+			if (would_convert_to_git(index, ce->name))
+				continue;
+			ALLOC_GROW(racy, nr + 1, alloc);
+			racy[nr++] = ce;
+		}
+		FREE_AND_NULL(p->racy);
+	}
+	if (!nr)
+		return;
+
+	trace2_region_enter("index", "preload/racy", NULL);
+	if (threads > nr)
+		threads = nr;
+	work = DIV_ROUND_UP(nr, threads);
+	memset(&rdata, 0, sizeof(rdata));
+	for (i = 0; i < threads; i++) {
+		struct racy_data *p = rdata + i;
+		int err;
+
+		p->index = index;
+		p->racy = racy + i * work;
+		p->nr = i == threads - 1 ? nr - i * work : work;
+		if (p->nr <= 0)
+			break;
+		err = pthread_create(&p->pthread, NULL, verify_racy_thread, p);
+		if (err)
+			die(_("unable to create threaded racy check: %s"), strerror(err));
+	}
+	threads = i;
+	for (i = 0; i < threads; i++) {
+		struct racy_data *p = rdata + i;
+		if (pthread_join(p->pthread, NULL))
+			die(_("unable to join threaded racy check"));
+		t2_sum_verified += p->t2_nr_verified;
+	}
+	free(racy);
+
+	trace2_data_intmax("index", NULL, "preload/racy_candidates", nr);
+	trace2_data_intmax("index", NULL, "preload/racy_verified", t2_sum_verified);
+	trace2_region_leave("index", "preload/racy", NULL);
+}
+
+/*
+ * Return the position of the first entry at or after "pos" that is
+ * not in the same directory as the entry before it, looking at most
+ * "max" entries ahead. Splitting the work there keeps the files of a
+ * directory in one thread, whose symlink cache then stays warm, and
+ * avoids two threads walking the same directory in the filesystem.
+ */
+static int next_directory_boundary(struct index_state *index, int pos, int max)
+{
+	const struct cache_entry *prev;
+	const char *slash;
+	int dirlen, end;
+
+	if (pos <= 0 || pos >= index->cache_nr)
+		return pos;
+	prev = index->cache[pos - 1];
+	slash = strrchr(prev->name, '/');
+	dirlen = slash ? slash - prev->name + 1 : 0;
+
+	end = pos + max;
+	if (end > index->cache_nr)
+		end = index->cache_nr;
+	for (; pos < end; pos++) {
+		const struct cache_entry *ce = index->cache[pos];
+
+		if (ce_namelen(ce) <= dirlen ||
+		    strncmp(ce->name, prev->name, dirlen) ||
+		    strchr(ce->name + dirlen, '/'))
+			return pos;
+	}
+	/* a huge directory; split it rather than unbalance the threads */
+	return end == index->cache_nr ? end : end - max;
+}
+
 void preload_index(struct index_state *index,
 		   const struct pathspec *pathspec,
 		   unsigned int refresh_flags)
@@ -134,16 +319,19 @@ void preload_index(struct index_state *index,
 
 	for (i = 0; i < threads; i++) {
 		struct thread_data *p = data+i;
-		int err;
+		int err, end;
 
 		p->index = index;
 		if (pathspec)
 			copy_pathspec(&p->pathspec, pathspec);
+		end = next_directory_boundary(index, (i + 1) * work, work / 4);
+		if (i == threads - 1 || end > index->cache_nr)
+			end = index->cache_nr;
 		p->offset = offset;
-		p->nr = work;
+		p->nr = end - offset;
 		if (pd.progress)
 			p->progress = &pd;
-		offset += work;
+		offset = end;
 		err = pthread_create(&p->pthread, NULL, preload_thread, p);
 
 		if (err)
@@ -152,11 +340,13 @@ void preload_index(struct index_state *index,
 	for (i = 0; i < threads; i++) {
 		struct thread_data *p = data+i;
 		if (pthread_join(p->pthread, NULL))
-			die("unable to join threaded lstat");
+			die(_("unable to join threaded lstat"));
 		t2_sum_lstat += p->t2_nr_lstat;
 	}
 	stop_progress(&pd.progress);
 
+	verify_racy_entries(index, data, threads);
+
 	if (pathspec) {
 		/* earlier we made deep copies for each thread to work with */
 		for (i = 0; i < threads; i++)
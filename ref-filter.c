@@ -29,6 +29,7 @@
 #include "worktree.h"
 #include "hashmap.h"
 #include "strvec.h"
+#include "trace2.h"
 
 static struct ref_msg {
 	const char *gone;
@@ -2304,6 +2305,8 @@ struct ref_filter_cbdata {
 	struct ref_filter *filter;
 	struct contains_cache contains_cache;
 	struct contains_cache no_contains_cache;
+	/* apply --[no-]contains to all refs at once after collecting them */
+	int batch_contains;
 };
 
 /*
@@ -2349,12 +2352,15 @@ static int ref_filter_handler(const char *refname, const struct object_id *oid,
 		commit = lookup_commit_reference_gently(the_repository, oid, 1);
 		if (!commit)
 			return 0;
-		/* We perform the filtering for the '--contains' option... */
-		if (filter->with_commit &&
+		/*
+		 * We perform the filtering for the '--contains' option,
+		 * unless contains_filter() does it for all refs later...
+		 */
+		if (filter->with_commit && !ref_cbdata->batch_contains &&
 		    !commit_contains(filter, commit, filter->with_commit, &ref_cbdata->contains_cache))
 			return 0;
 		/* ...or for the `--no-contains' option */
-		if (filter->no_commit &&
+		if (filter->no_commit && !ref_cbdata->batch_contains &&
 		    commit_contains(filter, commit, filter->no_commit, &ref_cbdata->no_contains_cache))
 			return 0;
 	}
@@ -2417,6 +2423,31 @@ void ref_array_clear(struct ref_array *array)
 
 #define EXCLUDE_REACHED 0
 #define INCLUDE_REACHED 1
+
+/*
+ * Keep the refs whose commit has (or, if !include_marked, has not)
+ * been marked UNINTERESTING, in their original order.
+ */
+static void keep_marked_refs(struct ref_array *array, int include_marked)
+{
+	int i, old_nr;
+
+	old_nr = array->nr;
+	array->nr = 0;
+
+	for (i = 0; i < old_nr; i++) {
+		struct ref_array_item *item = array->items[i];
+		struct commit *commit = item->commit;
+
+		int is_marked = !!(commit->object.flags & UNINTERESTING);
+
+		if (is_marked == include_marked)
+			array->items[array->nr++] = array->items[i];
+		else
+			free_array_item(item);
+	}
+}
+
 static void reach_filter(struct ref_array *array,
 			 struct commit_list *check_reachable,
 			 int include_reached)
@@ -2439,19 +2470,7 @@ static void reach_filter(struct ref_array *array,
 				  UNINTERESTING);
 
 	old_nr = array->nr;
-	array->nr = 0;
-
-	for (i = 0; i < old_nr; i++) {
-		struct ref_array_item *item = array->items[i];
-		struct commit *commit = item->commit;
-
-		int is_merged = !!(commit->object.flags & UNINTERESTING);
-
-		if (is_merged == include_reached)
-			array->items[array->nr++] = array->items[i];
-		else
-			free_array_item(item);
-	}
+	keep_marked_refs(array, include_reached);
 
 	clear_commit_marks_many(old_nr, to_clear, ALL_REV_FLAGS);
 
@@ -2504,6 +2523,36 @@ void filter_ahead_behind(struct repository *r,
 	free(commits);
 }
 
+/*
+ * Apply --contains (include_containing) or --no-contains to all the
+ * collected refs with a single walk, rather than walking from each ref
+ * in turn as ref_filter_handler() does otherwise.
+ */
+static void contains_filter(struct ref_array *array,
+			    struct commit_list *with_commit,
+			    int include_containing)
+{
+	int i, old_nr;
+	struct commit **tips;
+
+	if (!with_commit)
+		return;
+
+	CALLOC_ARRAY(tips, array->nr);
+	for (i = 0; i < array->nr; i++)
+		tips[i] = array->items[i]->commit;
+
+	tips_reaching_commits(the_repository, with_commit,
+			      tips, array->nr, UNINTERESTING);
+
+	old_nr = array->nr;
+	keep_marked_refs(array, include_containing);
+
+	for (i = 0; i < old_nr; i++)
+		tips[i]->object.flags &= ~UNINTERESTING;
+	free(tips);
+}
+
 /*
  * API for filtering a set of refs. Based on the type of refs the user
  * has requested, we iterate through those refs and apply filters
@@ -2518,6 +2567,8 @@ int filter_refs(struct ref_array *array, struct ref_filter *filter, unsigned int
 
 	ref_cbdata.array = array;
 	ref_cbdata.filter = filter;
+	ref_cbdata.batch_contains = !filter->with_commit_tag_algo &&
+		generation_numbers_enabled(the_repository);
 
 	filter->kind = type & FILTER_REFS_KIND_MASK;
 
@@ -2553,6 +2604,10 @@ int filter_refs(struct ref_array *array, struct ref_filter *filter, unsigned int
 	clear_contains_cache(&ref_cbdata.no_contains_cache);
 
 	/*  Filters that need revision walking */
+	if (ref_cbdata.batch_contains) {
+		contains_filter(array, filter->with_commit, INCLUDE_REACHED);
+		contains_filter(array, filter->no_commit, EXCLUDE_REACHED);
+	}
 	reach_filter(array, filter->reachable_from, INCLUDE_REACHED);
 	reach_filter(array, filter->unreachable_from, EXCLUDE_REACHED);
 
@@ -2675,9 +2730,139 @@ void ref_sorting_set_sort_flags_all(struct ref_sorting *sorting,
 	}
 }
 
+/*
+ * Sorting by the committer date of commits is common, and with a
+ * commit-graph the date can be had without reading the commit at all.
+ * Before sorting, collect such keys into one column per sort key, so
+ * that comparing two refs does not go through populate_value(), which
+ * would parse the object and compute every atom of the format for
+ * every ref, even those that "--count" is about to throw away.  Refs
+ * whose key is not in the column fall back to cmp_ref_sorting().
+ */
+struct sort_column {
+	timestamp_t *value;
+	unsigned char *known;
+};
+
+struct sort_context {
+	struct ref_sorting *sorting;
+	struct ref_array_item **items;
+	struct sort_column *columns;
+};
+
+static int is_graph_date_atom(struct ref_sorting *s)
+{
+	const struct used_atom *atom = &used_atom[s->atom];
+
+	if (s->sort_flags & REF_SORTING_VERSION)
+		return 0;
+	if (atom->atom_type != ATOM_COMMITTERDATE &&
+	    atom->atom_type != ATOM_CREATORDATE)
+		return 0;
+	/* "*committerdate" is about the object a tag points at */
+	return *atom->name != '*';
+}
+
+static int fill_sort_column(struct sort_column *col, struct ref_array *array)
+{
+	int i, nr = 0;
+
+	CALLOC_ARRAY(col->value, array->nr);
+	CALLOC_ARRAY(col->known, array->nr);
+	for (i = 0; i < array->nr; i++) {
+		struct ref_array_item *item = array->items[i];
+		struct commit *commit;
+
+		if (item->value)
+			continue;
+		commit = lookup_commit_in_graph(the_repository, &item->objectname);
+		if (!commit)
+			continue;
+		col->value[i] = commit->date;
+		col->known[i] = 1;
+		nr++;
+	}
+	return nr;
+}
+
+static int cmp_sort_column(struct ref_sorting *s, struct sort_column *col,
+			   struct ref_array_item **items, int a, int b)
+{
+	int cmp;
+
+	if (!col->value || !col->known[a] || !col->known[b] ||
+	    (s->sort_flags & REF_SORTING_DETACHED_HEAD_FIRST &&
+	     ((items[a]->kind | items[b]->kind) & FILTER_REFS_DETACHED_HEAD)))
+		return cmp_ref_sorting(s, items[a], items[b]);
+
+	if (col->value[a] < col->value[b])
+		cmp = -1;
+	else if (col->value[a] == col->value[b])
+		cmp = 0;
+	else
+		cmp = 1;
+	return s->sort_flags & REF_SORTING_REVERSE ? -cmp : cmp;
+}
+
+static int compare_ref_positions(const void *a_, const void *b_, void *ctx_)
+{
+	int a = *(const int *)a_;
+	int b = *(const int *)b_;
+	struct sort_context *ctx = ctx_;
+	struct ref_sorting *s;
+	int i;
+
+	for (s = ctx->sorting, i = 0; s; s = s->next, i++) {
+		int cmp = cmp_sort_column(s, &ctx->columns[i], ctx->items, a, b);
+		if (cmp)
+			return cmp;
+	}
+	s = ctx->sorting;
+	return s && s->sort_flags & REF_SORTING_ICASE ?
+		strcasecmp(ctx->items[a]->refname, ctx->items[b]->refname) :
+		strcmp(ctx->items[a]->refname, ctx->items[b]->refname);
+}
+
 void ref_array_sort(struct ref_sorting *sorting, struct ref_array *array)
 {
-	QSORT_S(array->items, array->nr, compare_refs, sorting);
+	struct sort_context ctx = { .sorting = sorting, .items = array->items };
+	struct ref_array_item **sorted;
+	struct ref_sorting *s;
+	int *order;
+	int i, nr_keys = 0, nr_graph_dates = 0;
+
+	for (s = sorting; s; s = s->next)
+		nr_keys++;
+	CALLOC_ARRAY(ctx.columns, nr_keys);
+	for (s = sorting, i = 0; s; s = s->next, i++)
+		if (array->nr > 1 && is_graph_date_atom(s))
+			nr_graph_dates += fill_sort_column(&ctx.columns[i], array);
+
+	if (!nr_graph_dates) {
+		QSORT_S(array->items, array->nr, compare_refs, sorting);
+		goto out;
+	}
+
+	trace2_data_intmax("ref-filter", the_repository, "sort/graph_dates",
+			   nr_graph_dates);
+	ALLOC_ARRAY(order, array->nr);
+	for (i = 0; i < array->nr; i++)
+		order[i] = i;
+	QSORT_S(order, array->nr, compare_ref_positions, &ctx);
+
+	ALLOC_ARRAY(sorted, array->nr);
+	for (i = 0; i < array->nr; i++)
+		sorted[i] = array->items[order[i]];
+	COPY_ARRAY(array->items, sorted, array->nr);
+	free(sorted);
+	free(order);
+
+out:
+	for (i = 0; i < nr_keys; i++) {
+		free(ctx.columns[i].value);
+		free(ctx.columns[i].known);
+	}
+	free(ctx.columns);
 }
 
 static void append_literal(const char *cp, const char *ep, struct ref_formatting_state *state)
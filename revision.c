@@ -667,25 +667,53 @@ static void trace2_bloom_filter_statistics_atexit(void)
 
 static int forbid_bloom_filters(struct pathspec *spec)
 {
-	if (spec->has_wildcard)
-		return 1;
-	if (spec->nr > 1)
-		return 1;
+	int i;
+
 	if (spec->magic & ~PATHSPEC_LITERAL)
 		return 1;
-	if (spec->nr && (spec->items[0].magic & ~PATHSPEC_LITERAL))
-		return 1;
+	for (i = 0; i < spec->nr; i++)
+		if (spec->items[i].magic & ~PATHSPEC_LITERAL)
+			return 1;
 
 	return 0;
 }
 
+/*
+ * Return how much of the path in "pi" can be looked up in the Bloom
+ * filters: all of it, or, if it has wildcards, the leading directories
+ * before the first one, whose keys the writer adds for any path below
+ * them. Returns 0 if the pathspec item can match at the top level.
+ */
+static size_t bloom_filter_prefix_len(const struct pathspec_item *pi)
+{
+	size_t len = pi->len;
+
+	if (pi->nowildcard_len < pi->len) {
+		len = pi->nowildcard_len;
+		while (len > 0 && pi->match[len - 1] != '/')
+			len--;
+	}
+
+	/* remove single trailing slash from path, if needed */
+	if (len > 0 && pi->match[len - 1] == '/')
+		len--;
+
+	return len;
+}
+
+static void release_bloom_keyvecs(struct rev_info *revs)
+{
+	int i;
+
+	for (i = 0; i < revs->bloom_keyvecs_nr; i++)
+		clear_bloom_keyvec(&revs->bloom_keyvecs[i]);
+	FREE_AND_NULL(revs->bloom_keyvecs);
+	revs->bloom_keyvecs_nr = 0;
+}
+
 static void prepare_to_use_bloom_filter(struct rev_info *revs)
 {
-	struct pathspec_item *pi;
-	char *path_alloc = NULL;
-	const char *path, *p;
-	size_t len;
-	int path_component_nr = 1;
+	int i;
 
 	if (!revs->commits)
 		return;
@@ -702,63 +730,32 @@ static void prepare_to_use_bloom_filter(struct rev_info *revs)
 	if (!revs->pruning.pathspec.nr)
 		return;
 
-	pi = &revs->pruning.pathspec.items[0];
-
-	/* remove single trailing slash from path, if needed */
-	if (pi->len > 0 && pi->match[pi->len - 1] == '/') {
-		path_alloc = xmemdupz(pi->match, pi->len - 1);
-		path = path_alloc;
-	} else
-		path = pi->match;
-
-	len = strlen(path);
-	if (!len) {
-		revs->bloom_filter_settings = NULL;
-		free(path_alloc);
-		return;
-	}
-
-	p = path;
-	while (*p) {
-		/*
-		 * At this point, the path is normalized to use Unix-style
-		 * path separators. This is required due to how the
-		 * changed-path Bloom filters store the paths.
-		 */
-		if (*p == '/')
-			path_component_nr++;
-		p++;
-	}
-
-	revs->bloom_keys_nr = path_component_nr;
-	ALLOC_ARRAY(revs->bloom_keys, revs->bloom_keys_nr);
-
-	fill_bloom_key(path, len, &revs->bloom_keys[0],
-		       revs->bloom_filter_settings);
-	path_component_nr = 1;
+	CALLOC_ARRAY(revs->bloom_keyvecs, revs->pruning.pathspec.nr);
+	for (i = 0; i < revs->pruning.pathspec.nr; i++) {
+		const struct pathspec_item *pi = &revs->pruning.pathspec.items[i];
+		size_t len = bloom_filter_prefix_len(pi);
 
-	p = path + len - 1;
-	while (p > path) {
-		if (*p == '/')
-			fill_bloom_key(path, p - path,
-				       &revs->bloom_keys[path_component_nr++],
-				       revs->bloom_filter_settings);
-		p--;
+		if (!len) {
+			release_bloom_keyvecs(revs);
+			revs->bloom_filter_settings = NULL;
+			return;
+		}
+		fill_bloom_keyvec(&revs->bloom_keyvecs[i], pi->match, len,
+				  revs->bloom_filter_settings);
+		revs->bloom_keyvecs_nr++;
 	}
 
 	if (trace2_is_enabled() && !bloom_filter_atexit_registered) {
 		atexit(trace2_bloom_filter_statistics_atexit);
 		bloom_filter_atexit_registered = 1;
 	}
-
-	free(path_alloc);
 }
 
 static int check_maybe_different_in_bloom_filter(struct rev_info *revs,
 						 struct commit *commit)
 {
 	struct bloom_filter *filter;
-	int result = 1, j;
+	int result = 0, j;
 
 	if (!revs->repo->objects->commit_graph)
 		return -1;
@@ -773,10 +770,11 @@ static int check_maybe_different_in_bloom_filter(struct rev_info *revs,
 		return -1;
 	}
 
-	for (j = 0; result && j < revs->bloom_keys_nr; j++) {
-		result = bloom_filter_contains(filter,
-					       &revs->bloom_keys[j],
-					       revs->bloom_filter_settings);
+	/* the commit may matter if it may have changed any of the paths */
+	for (j = 0; !result && j < revs->bloom_keyvecs_nr; j++) {
+		result = bloom_filter_contains_vec(filter,
+						   &revs->bloom_keyvecs[j],
+						   revs->bloom_filter_settings);
 	}
 
 	if (result)
@@ -817,7 +815,7 @@ static int rev_compare_tree(struct rev_info *revs,
 			return REV_TREE_SAME;
 	}
 
-	if (revs->bloom_keys_nr && !nth_parent) {
+	if (revs->bloom_keyvecs_nr && !nth_parent) {
 		bloom_ret = check_maybe_different_in_bloom_filter(revs, commit);
 
 		if (bloom_ret == 0)
@@ -3094,6 +3092,8 @@ void release_revisions(struct rev_info *revs)
 	diff_free(&revs->pruning);
 	reflog_walk_info_release(revs->reflog_info);
 	release_revisions_topo_walk_info(revs->topo_walk_info);
+	release_bloom_keyvecs(revs);
+	line_log_release_bloom_keys(revs);
 }
 
 static void add_child(struct rev_info *revs, struct commit *parent, struct commit *child)
@@ -3855,7 +3855,18 @@ static void merge_queue_into_list(struct prio_queue *q, struct commit_list **lis
 static enum rewrite_result rewrite_one(struct rev_info *revs, struct commit **pp)
 {
 	struct prio_queue queue = { compare_commits_by_commit_date };
-	enum rewrite_result ret = rewrite_one_1(revs, pp, &queue);
+	enum rewrite_result ret;
+
+	/*
+	 * The incremental topo-order walk reaches these commits through
+	 * its own queues and never looks at revs->commits again, so do
+	 * not keep merging them into that list; it only grows, and each
+	 * merge walks it from the start.
+	 */
+	if (revs->topo_walk_info)
+		return rewrite_one_1(revs, pp, NULL);
+
+	ret = rewrite_one_1(revs, pp, &queue);
 	merge_queue_into_list(&queue, &revs->commits);
 	clear_prio_queue(&queue);
 	return ret;
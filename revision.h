@@ -60,8 +60,9 @@ struct repository;
 struct rev_info;
 struct string_list;
 struct saved_parents;
-struct bloom_key;
+struct bloom_keyvec;
 struct bloom_filter_settings;
+struct strmap;
 struct option;
 struct parse_opt_ctx_t;
 define_shared_commit_slab(revision_sources, char *);
@@ -355,9 +356,20 @@ struct rev_info {
 	struct topo_walk_info *topo_walk_info;
 
 	/* Commit graph bloom filter fields */
-	/* The bloom filter key(s) for the pathspec */
-	struct bloom_key *bloom_keys;
-	int bloom_keys_nr;
+	/*
+	 * The bloom filter keys for the pathspec, one set per pathspec
+	 * item; a commit may be TREESAME only if it can have changed
+	 * none of them.
+	 */
+	struct bloom_keyvec *bloom_keyvecs;
+	int bloom_keyvecs_nr;
+
+	/*
+	 * The bloom filter keys of the paths followed by "log -L", keyed
+	 * by path, so that they are not hashed again for every commit;
+	 * the paths only change at renames.
+	 */
+	struct strmap *line_log_bloom_keys;
 
 	/*
 	 * The bloom filter settings used to generate the key.
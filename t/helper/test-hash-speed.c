@@ -3,38 +3,98 @@
 
 #define NUM_SECONDS 3
 
-static inline void compute_hash(const struct git_hash_algo *algo, git_hash_ctx *ctx, uint8_t *final, const void *p, size_t len)
+/*
+ * Besides the real hash algorithms, allow timing the collision-detecting
+ * SHA-1 with parts of its detection switched off, to see how much of its
+ * cost is spent on the collision check rather than on SHA-1 itself, and
+ * the "unsafe" SHA-1 used for checksums (see OPENSSL_SHA1_UNSAFE).
+ */
+struct hash_speed_variant {
+	const char *name;
+	const struct git_hash_algo *algo;
+	void (*tweak_fn)(git_hash_ctx *ctx);
+	int unsafe;
+};
+
+#ifdef platform_SHA_IS_SHA1DC
+static void sha1dc_no_detection(git_hash_ctx *ctx)
 {
-	algo->init_fn(ctx);
-	algo->update_fn(ctx, p, len);
-	algo->final_fn(final, ctx);
+	SHA1DCSetUseDetectColl(&ctx->sha1, 0);
 }
 
-int cmd__hash_speed(int ac, const char **av)
+static void sha1dc_no_ubc(git_hash_ctx *ctx)
+{
+	SHA1DCSetUseUBC(&ctx->sha1, 0);
+}
+
+static const struct {
+	const char *name;
+	void (*tweak_fn)(git_hash_ctx *ctx);
+} sha1dc_variants[] = {
+	{ "sha1-nodc", sha1dc_no_detection },
+	{ "sha1-noubc", sha1dc_no_ubc },
+};
+#endif
+
+static int lookup_variant(const char *name, struct hash_speed_variant *v)
+{
+	int i;
+
+	for (i = 1; i < GIT_HASH_NALGOS; i++) {
+		if (!strcmp(name, hash_algos[i].name)) {
+			v->name = name;
+			v->algo = &hash_algos[i];
+			v->tweak_fn = NULL;
+			v->unsafe = 0;
+			return 0;
+		}
+	}
+	if (!strcmp(name, "sha1-unsafe")) {
+		v->name = name;
+		v->algo = &hash_algos[GIT_HASH_SHA1];
+		v->tweak_fn = NULL;
+		v->unsafe = 1;
+		return 0;
+	}
+#ifdef platform_SHA_IS_SHA1DC
+	for (i = 0; i < ARRAY_SIZE(sha1dc_variants); i++) {
+		if (!strcmp(name, sha1dc_variants[i].name)) {
+			v->name = name;
+			v->algo = &hash_algos[GIT_HASH_SHA1];
+			v->tweak_fn = sha1dc_variants[i].tweak_fn;
+			v->unsafe = 0;
+			return 0;
+		}
+	}
+#endif
+	return -1;
+}
+
+static inline void compute_hash(const struct hash_speed_variant *v, git_hash_ctx *ctx, uint8_t *final, const void *p, size_t len)
+{
+	if (v->unsafe) {
+		v->algo->unsafe_init_fn(ctx);
+		v->algo->unsafe_update_fn(ctx, p, len);
+		v->algo->unsafe_final_fn(final, ctx);
+		return;
+	}
+	v->algo->init_fn(ctx);
+	if (v->tweak_fn)
+		v->tweak_fn(ctx);
+	v->algo->update_fn(ctx, p, len);
+	v->algo->final_fn(final, ctx);
+}
+
+static void time_variant(const struct hash_speed_variant *v, clock_t initial)
 {
 	git_hash_ctx ctx;
 	unsigned char hash[GIT_MAX_RAWSZ];
-	clock_t initial, start, end;
+	clock_t start, end;
 	unsigned bufsizes[] = { 64, 256, 1024, 8192, 16384 };
 	int i;
 	void *p;
-	const struct git_hash_algo *algo = NULL;
-
-	if (ac == 2) {
-		for (i = 1; i < GIT_HASH_NALGOS; i++) {
-			if (!strcmp(av[1], hash_algos[i].name)) {
-				algo = &hash_algos[i];
-				break;
-			}
-		}
-	}
-	if (!algo)
-		die("usage: test-tool hash-speed algo_name");
 
-	/* Use this as an offset to make overflow less likely. */
-	initial = clock();
-
-	printf("algo: %s\n", algo->name);
+	printf("algo: %s\n", v->name);
 
 	for (i = 0; i < ARRAY_SIZE(bufsizes); i++) {
 		unsigned long j, kb;
@@ -42,7 +102,7 @@ int cmd__hash_speed(int ac, const char **av)
 		p = xcalloc(1, bufsizes[i]);
 		start = end = clock() - initial;
 		for (j = 0; ((end - start) / CLOCKS_PER_SEC) < NUM_SECONDS; j++) {
-			compute_hash(algo, &ctx, hash, p, bufsizes[i]);
+			compute_hash(v, &ctx, hash, p, bufsizes[i]);
 
 			/*
 			 * Only check elapsed time every 128 iterations to avoid
@@ -56,6 +116,28 @@ int cmd__hash_speed(int ac, const char **av)
 		printf("size %u: %lu iters; %lu KiB; %0.2f KiB/s\n", bufsizes[i], j, kb, kb_per_sec);
 		free(p);
 	}
+}
+
+int cmd__hash_speed(int ac, const char **av)
+{
+	struct hash_speed_variant *variants;
+	clock_t initial;
+	int i;
+
+	if (ac < 2)
+		die("usage: test-tool hash-speed algo_name...");
+
+	ALLOC_ARRAY(variants, ac - 1);
+	for (i = 1; i < ac; i++)
+		if (lookup_variant(av[i], &variants[i - 1]))
+			die("unknown hash algorithm '%s'", av[i]);
+
+	/* Use this as an offset to make overflow less likely. */
+	initial = clock();
+
+	for (i = 0; i < ac - 1; i++)
+		time_variant(&variants[i], initial);
 
+	free(variants);
 	return 0;
 }
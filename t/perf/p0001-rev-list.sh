@@ -45,4 +45,14 @@ test_perf 'rev-list --objects $commit --not --all' '
 	git rev-list --objects $commit --not --all >/dev/null
 '
 
+test_expect_success 'write commit-graph, find a busy path' '
+	git commit-graph write --reachable --changed-paths &&
+	busy_path=$(test_perf_busy_path) &&
+	test_export busy_path
+'
+
+test_perf 'rev-list --topo-order --parents -- $busy_path' '
+	git rev-list --topo-order --parents HEAD -- "$busy_path" >/dev/null
+'
+
 test_done
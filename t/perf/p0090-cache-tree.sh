@@ -33,4 +33,18 @@ test_cache_tree_update_functions "invalidate 2" "--invalidate 2"
 test_cache_tree_update_functions "invalidate 50" "--invalidate 50"
 test_cache_tree_update_functions "empty" "--empty"
 
+test_expect_success 'setup one-line commit' '
+	nr_files=$(git ls-files | wc -l) &&
+	file=$(git ls-files -s | sed -n "/^100644 /{s/^[^	]*	//p;q;}") &&
+	export nr_files file &&
+	git config user.name perf &&
+	git config user.email perf@example.com
+'
+
+test_perf "commit a one-line change ($nr_files files)" '
+	echo change >>"$file" &&
+	git add "$file" &&
+	git commit -q --no-verify -m change
+'
+
 test_done
@@ -47,4 +47,20 @@ test_perf 'contains: git tag --merged' '
 	xargs git tag --merged=HEAD <tags
 '
 
+test_perf 'contains: git for-each-ref --contains' '
+	git for-each-ref --contains=HEAD~10 --stdin <refs
+'
+
+test_perf 'contains: git branch --contains' '
+	xargs git branch --contains=HEAD~10 <branches
+'
+
+test_perf 'contains: git tag --contains' '
+	xargs git tag --contains=HEAD~10 <tags
+'
+
+test_perf 'sort: git for-each-ref --sort=-committerdate --count=20' '
+	git for-each-ref --sort=-committerdate --count=20 --stdin <refs
+'
+
 test_done
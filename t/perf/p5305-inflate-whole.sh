@@ -0,0 +1,29 @@
+#!/bin/sh
+
+test_description='reading and writing whole non-delta pack objects
+
+Reading a non-delta object from a pack and compressing an object in
+pack-objects can go through git_inflate_whole() and git_deflate_whole(),
+which only do something in builds with USE_LIBDEFLATE. Compare such a
+build against a plain one, e.g.
+
+	./run /path/to/plain/build /path/to/libdeflate/build p5305-inflate-whole.sh
+'
+. ./perf-lib.sh
+
+test_perf_default_repo
+
+test_expect_success 'repack without deltas' '
+	git repack -adf --window=0 --depth=0
+'
+
+test_perf 'cat-file --batch of all objects' '
+	git cat-file --batch-all-objects --batch >/dev/null
+'
+
+test_perf 'pack-objects without reuse or deltas' '
+	git -c pack.allowPackReuse=false pack-objects --all --stdout \
+		--no-reuse-object --window=0 </dev/null >/dev/null
+'
+
+test_done
@@ -0,0 +1,49 @@
+#!/bin/sh
+
+test_description='cost of the untracked-file scan in "git status"
+
+Time "git status" with the untracked cache disabled, with a warm cache,
+and with a cache that has just been invalidated by switching branches,
+to see how much of status is spent walking the worktree in
+read_directory(). Without the cache, compare the threaded scan of the
+top-level directories against a single thread.
+'
+. ./perf-lib.sh
+
+test_perf_default_repo
+test_checkout_worktree
+
+test_expect_success 'setup' '
+	git config core.untrackedCache false &&
+	git branch p7301-other HEAD~1 &&
+	mkdir -p p7301-untracked &&
+	for i in $(test_seq 1 100)
+	do
+		mkdir p7301-untracked/dir$i &&
+		>p7301-untracked/dir$i/file || return 1
+	done
+'
+
+test_perf 'status -uall, no untracked cache' '
+	git status -uall >/dev/null
+'
+
+test_perf 'status -uall, no untracked cache, one scan thread' '
+	GIT_TEST_DIR_SCAN_THREADS=1 git status -uall >/dev/null
+'
+
+test_expect_success 'enable and populate the untracked cache' '
+	git config core.untrackedCache true &&
+	git status -uall >/dev/null
+'
+
+test_perf 'status -uall, warm untracked cache' '
+	git status -uall >/dev/null
+'
+
+test_perf 'status -uall, after switching branches' \
+	--setup 'git checkout -q p7301-other && git checkout -q - ' '
+	git status -uall >/dev/null
+'
+
+test_done
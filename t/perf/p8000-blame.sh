@@ -0,0 +1,20 @@
+#!/bin/sh
+
+test_description='performance of git-blame'
+. ./perf-lib.sh
+
+test_perf_default_repo
+
+test_expect_success 'find a busy path' '
+	busy_path=$(test_perf_busy_path) &&
+	test_export busy_path
+'
+
+for threads in 1 4
+do
+	test_perf "blame \$busy_path (blame.threads=$threads)" "
+		git -c blame.threads=$threads blame HEAD -- \"\$busy_path\" >/dev/null
+	"
+done
+
+test_done
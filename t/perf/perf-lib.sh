@@ -161,6 +161,12 @@ test_checkout_worktree () {
 	error "git checkout-index failed"
 }
 
+# Print the path changed by the most of the last 1000 commits on HEAD.
+test_perf_busy_path () {
+	git log --format= --name-only -1000 HEAD |
+	sort | uniq -c | sort -rn | sed -n "1s/^ *[0-9]* //p"
+}
+
 # Performance tests should never fail.  If they do, stop immediately
 immediate=t
 
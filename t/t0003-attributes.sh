@@ -399,6 +399,30 @@ test_expect_success 'query binary macro directly' '
 	test_cmp expect actual
 '
 
+test_expect_success 'macros expand the same way across directories' '
+	test_when_finished "rm -rf .gitattributes mdir1 mdir2" &&
+	mkdir mdir1 mdir2 &&
+	cat >.gitattributes <<-\EOF &&
+	[attr]mymacro test=macro
+	*.m mymacro
+	EOF
+	echo "*.m -mymacro" >mdir1/.gitattributes &&
+	printf "%s\n" f.m mdir1/f.m mdir1/g.m mdir2/f.m f.m mdir1/f.m >stdin &&
+	cat >expect <<-\EOF &&
+	f.m: test: macro
+	f.m: mymacro: set
+	mdir1/f.m: mymacro: unset
+	mdir1/g.m: mymacro: unset
+	mdir2/f.m: test: macro
+	mdir2/f.m: mymacro: set
+	f.m: test: macro
+	f.m: mymacro: set
+	mdir1/f.m: mymacro: unset
+	EOF
+	git check-attr --stdin --all <stdin >actual &&
+	test_cmp expect actual
+'
+
 test_expect_success SYMLINKS 'set up symlink tests' '
 	echo "* test" >attr &&
 	rm -f .gitattributes
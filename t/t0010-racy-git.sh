@@ -31,4 +31,22 @@ do
 
 done
 
+test_expect_success 'racily clean entries are verified by preload threads' '
+	rm -f .git/index &&
+	for i in 1 2 3 4 5 6 7 8
+	do
+		echo "racy $i" >racy-$i || return 1
+	done &&
+	test-tool chmtime =-10 racy-* &&
+	git update-index --add racy-* &&
+	echo "ytca 3" >racy-3 &&
+	test-tool chmtime =-10 .git/index racy-3 &&
+	GIT_TRACE2_EVENT="$(pwd)/trace.event" GIT_TEST_PRELOAD_INDEX=1 \
+		git -c core.preloadIndex=true -c core.trustctime=false \
+		diff-files --name-only >actual &&
+	echo racy-3 >expect &&
+	test_cmp expect actual &&
+	grep "\"key\":\"preload/racy_verified\",\"value\":\"7\"" trace.event
+'
+
 test_done
@@ -27,6 +27,18 @@ test_expect_success 'test basic SHA-1 hash values' '
 	grep 4b825dc642cb6eb9a060e54bf8d69288fbee4904 actual
 '
 
+test_expect_success 'test basic unsafe SHA-1 hash values' '
+	test-tool sha1-unsafe </dev/null >actual &&
+	grep da39a3ee5e6b4b0d3255bfef95601890afd80709 actual &&
+	printf "abc" | test-tool sha1-unsafe >actual &&
+	grep a9993e364706816aba3e25717850c26c9cd0d89d actual &&
+	perl -e "$| = 1; print q{aaaaaaaaaa} for 1..100000;" |
+		test-tool sha1-unsafe >actual &&
+	grep 34aa973cd4c4daa4f61eeb2bdbad27316534016f actual &&
+	printf "blob 3\0abc" | test-tool sha1-unsafe >actual &&
+	grep f2ba8f84ab5c1bce84a7b441cb1959cfc7093b7f actual
+'
+
 test_expect_success 'test basic SHA-256 hash values' '
 	test-tool sha256 </dev/null >actual &&
 	grep e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855 actual &&
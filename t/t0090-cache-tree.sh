@@ -279,4 +279,25 @@ test_expect_success 'switching trees does not invalidate shared index' '
 	)
 '
 
+test_expect_success 'write-tree notices unmerged entries next to valid subtrees' '
+	git checkout -b unmerged-subtree no-children &&
+	mkdir -p valid unmerged &&
+	echo valid >valid/file &&
+	echo unmerged >unmerged/file &&
+	echo top >top &&
+	git add valid unmerged top &&
+	git write-tree &&
+	blob=$(git rev-parse :unmerged/file) &&
+	git update-index --force-remove unmerged/file &&
+	cat >index-info <<-EOF &&
+	100644 $blob 1	unmerged/file
+	100644 $blob 2	unmerged/file
+	EOF
+	git update-index --index-info <index-info &&
+	test_must_fail git write-tree 2>err &&
+	grep "unmerged/file: unmerged" err &&
+	git update-index --force-remove unmerged/file &&
+	git write-tree
+'
+
 test_done
@@ -109,4 +109,18 @@ test_expect_success 'Porcelain checkout -f HEAD should remove remnants too' '
 	test_cmp expect actual
 '
 
+test_expect_success 'read-tree -m does not grow the result index pool' '
+	test_create_repo presize &&
+	(
+		cd presize &&
+		blob=$(echo content | git hash-object -w --stdin) &&
+		test_seq 30000 |
+		sed "s|.*|100644 $blob	file&|" |
+		git update-index --index-info &&
+		tree=$(git write-tree) &&
+		GIT_TRACE2_EVENT="$(pwd)/trace.event" git read-tree -m $tree &&
+		grep "\"key\":\"result/pool_blocks\",\"value\":\"1\"" trace.event
+	)
+'
+
 test_done
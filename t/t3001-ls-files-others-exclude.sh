@@ -304,4 +304,38 @@ test_expect_success 'ls-files with "**" patterns and no slashes' '
 	test_must_be_empty actual
 '
 
+test_expect_success 'last match wins across literal, suffix and glob patterns' '
+	git init last-match &&
+	(
+		cd last-match &&
+		mkdir build sub &&
+		>build/file &&
+		>sub/build &&
+		>a.o &&
+		>keep.o &&
+		>keep2.o &&
+		>important.txt &&
+		>other.txt &&
+		cat >.gitignore <<-\EOF &&
+		*.o
+		!keep.o
+		!keep?.o
+		ke?p2.o
+		build/
+		!*.txt
+		important.txt
+		*.txt
+		!other.txt
+		EOF
+		git ls-files -o -i --exclude-standard >actual &&
+		cat >expect <<-\EOF &&
+		a.o
+		build/file
+		important.txt
+		keep2.o
+		EOF
+		test_cmp expect actual
+	)
+'
+
 test_done
@@ -121,8 +121,10 @@ test_expect_success 'git log with --walk-reflogs does not use Bloom filters' '
 	test_bloom_filters_not_used "--walk-reflogs -- A"
 '
 
-test_expect_success 'git log -- multiple path specs does not use Bloom filters' '
-	test_bloom_filters_not_used "-- file4 A/file1"
+test_expect_success 'git log -- multiple path specs uses Bloom filters' '
+	test_bloom_filters_used "-- file4 A/file1" &&
+	test_bloom_filters_used "-- A/B/C file5_renamed" &&
+	test_bloom_filters_used "-- A/B path_does_not_exist"
 '
 
 test_expect_success 'git log -- "." pathspec at root does not use Bloom filters' '
@@ -134,9 +136,31 @@ test_expect_success 'git log with wildcard that resolves to a single path uses B
 	test_bloom_filters_used "-- *renamed"
 '
 
-test_expect_success 'git log with wildcard that resolves to a multiple paths does not uses Bloom filters' '
-	test_bloom_filters_not_used "-- *" &&
-	test_bloom_filters_not_used "-- file*"
+test_expect_success 'git log with wildcard that resolves to a multiple paths uses Bloom filters' '
+	test_bloom_filters_used "-- *" &&
+	test_bloom_filters_used "-- file*"
+'
+
+# The shell leaves these patterns alone, as they match nothing in the
+# working tree, so it is git that sees the wildcards.
+test_expect_success 'git log with a wildcard pathspec uses Bloom filters for its leading directories' '
+	test_bloom_filters_used "-- A/B/*3" &&
+	test_bloom_filters_used "-- A/*3 file4"
+'
+
+test_expect_success 'git log with a wildcard pathspec at the top level does not use Bloom filters' '
+	test_bloom_filters_not_used "-- f*_to_be_deleted" &&
+	test_bloom_filters_not_used "-- A/file1 f*_to_be_deleted"
+'
+
+test_expect_success 'git log -L uses Bloom filters, also across renames' '
+	git -c core.commitGraph=false log --format=%s -L1,1:file5_renamed >expect &&
+	rm -f "$TRASH_DIRECTORY/trace.perf" &&
+	GIT_TRACE2_PERF="$TRASH_DIRECTORY/trace.perf" \
+		git -c core.commitGraph=true log --format=%s -L1,1:file5_renamed >actual &&
+	test_cmp expect actual &&
+	grep "c11" actual &&
+	grep "bloom/definitely_not:[1-9]" "$TRASH_DIRECTORY/trace.perf"
 '
 
 test_expect_success 'setup - add commit-graph to the chain without Bloom filters' '
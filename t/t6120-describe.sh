@@ -606,6 +606,24 @@ test_expect_success 'name-rev --annotate-stdin works with commitGraph' '
 	)
 '
 
+test_expect_success 'name-rev --annotate-stdin with commitGraph names lazily' '
+	test_when_finished "rm -f .git/objects/info/commit-graph" &&
+	git log --all --pretty=%H >revs &&
+	sort revs >revs-sorted &&
+	git log --all --reverse --pretty=%H >revs-reversed &&
+	for input in revs revs-sorted revs-reversed
+	do
+		git -c core.commitGraph=false name-rev --annotate-stdin \
+			<$input >expect-$input || return 1
+	done &&
+	git commit-graph write --reachable &&
+	for input in revs revs-sorted revs-reversed
+	do
+		git name-rev --annotate-stdin <$input >actual &&
+		test_cmp expect-$input actual || return 1
+	done
+'
+
 #               B
 #               o
 #                \
@@ -663,4 +681,31 @@ test_expect_success 'setup misleading taggerdates' '
 
 check_describe newer-tag-older-commit~1 --contains unique-file~2
 
+test_expect_success 'describe --stdin describes every line' '
+	git rev-list --all >revs &&
+	while read rev
+	do
+		git describe --tags --always $rev || return 1
+	done <revs >expect &&
+	git describe --tags --always --stdin <revs >actual &&
+	test_cmp expect actual
+'
+
+test_expect_success 'describe --stdin works with blobs' '
+	echo HEAD:file >input &&
+	echo HEAD >>input &&
+	git describe --tags HEAD:file HEAD >expect &&
+	git describe --tags --stdin <input >actual &&
+	test_cmp expect actual
+'
+
+test_expect_success 'describe --stdin rejects incompatible options' '
+	test_must_fail git describe --stdin HEAD </dev/null 2>err &&
+	test_i18ngrep "cannot be used together" err &&
+	test_must_fail git describe --stdin --contains </dev/null 2>err &&
+	test_i18ngrep "cannot be used together" err &&
+	test_must_fail git describe --stdin --dirty </dev/null 2>err &&
+	test_i18ngrep "cannot be used together" err
+'
+
 test_done
@@ -1039,6 +1039,33 @@ test_expect_success '--no-sort cancels the previous sort keys' '
 	test_cmp expected actual
 '
 
+test_expect_success 'sorting by committer date reads it from the commit-graph' '
+	test_when_finished "rm -f .git/objects/info/commit-graph trace" &&
+	for key in committerdate creatordate
+	do
+		git -c core.commitGraph=false for-each-ref \
+			--format="%($key:unix) %(objecttype) %(refname)" \
+			--sort=-$key >expect-$key &&
+		git -c core.commitGraph=false for-each-ref --count=3 \
+			--format="%($key:unix) %(refname)" \
+			--sort=refname --sort=-$key >expect-$key-count || return 1
+	done &&
+	git commit-graph write --reachable &&
+	for key in committerdate creatordate
+	do
+		rm -f trace &&
+		GIT_TRACE2_EVENT="$(pwd)/trace" git for-each-ref \
+			--format="%($key:unix) %(objecttype) %(refname)" \
+			--sort=-$key >actual &&
+		test_cmp expect-$key actual &&
+		grep "\"key\":\"sort/graph_dates\"" trace &&
+		git for-each-ref --count=3 \
+			--format="%($key:unix) %(refname)" \
+			--sort=refname --sort=-$key >actual &&
+		test_cmp expect-$key-count actual || return 1
+	done
+'
+
 test_expect_success 'do not dereference NULL upon %(HEAD) on unborn branch' '
 	test_when_finished "git checkout main" &&
 	git for-each-ref --format="%(HEAD) %(refname:short)" refs/heads/ >actual &&
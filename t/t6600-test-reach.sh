@@ -529,6 +529,29 @@ test_expect_success 'for-each-ref ahead-behind:none' '
 		--format="%(refname) %(ahead-behind:commit-8-4)" --stdin
 '
 
+test_expect_success 'for-each-ref ahead-behind skips STALE commits' '
+	cat >input <<-\EOF &&
+	refs/heads/commit-7-5
+	refs/heads/commit-4-8
+	refs/heads/commit-9-9
+	EOF
+	cat >expect <<-\EOF &&
+	refs/heads/commit-4-8 16 16
+	refs/heads/commit-7-5 7 4
+	refs/heads/commit-9-9 49 0
+	EOF
+	test_when_finished "rm -f .git/objects/info/commit-graph trace.txt" &&
+	cp commit-graph-full .git/objects/info/commit-graph &&
+	GIT_TRACE2_EVENT="$(pwd)/trace.txt" git for-each-ref \
+		--format="%(refname) %(ahead-behind:commit-8-4)" \
+		--stdin <input >actual &&
+	test_cmp expect actual &&
+	walked=$(sed -n "s/.*\"category\":\"ahead_behind\",\"key\":\"walked\",\"value\":\"\([0-9]*\)\".*/\1/p" trace.txt) &&
+	counted=$(sed -n "s/.*\"category\":\"ahead_behind\",\"key\":\"counted\",\"value\":\"\([0-9]*\)\".*/\1/p" trace.txt) &&
+	test -n "$counted" &&
+	test "$counted" -lt "$walked"
+'
+
 test_expect_success 'for-each-ref merged:linear' '
 	cat >input <<-\EOF &&
 	refs/heads/commit-1-1
@@ -612,4 +635,46 @@ test_expect_success 'for-each-ref merged:none' '
 		--format="%(refname)" --stdin
 '
 
+test_expect_success 'for-each-ref contains:some, multibase' '
+	cat >input <<-\EOF &&
+	refs/heads/commit-1-1
+	refs/heads/commit-5-3
+	refs/heads/commit-7-8
+	refs/heads/commit-4-8
+	refs/heads/commit-9-2
+	refs/heads/commit-3-5
+	EOF
+	cat >expect <<-\EOF &&
+	refs/heads/commit-4-8
+	refs/heads/commit-5-3
+	refs/heads/commit-7-8
+	EOF
+	run_all_modes git for-each-ref \
+		--contains=commit-5-3 \
+		--contains=commit-3-6 \
+		--format="%(refname)" \
+		--stdin
+'
+
+test_expect_success 'for-each-ref no-contains:some, multibase' '
+	cat >input <<-\EOF &&
+	refs/heads/commit-1-1
+	refs/heads/commit-5-3
+	refs/heads/commit-7-8
+	refs/heads/commit-4-8
+	refs/heads/commit-9-2
+	refs/heads/commit-3-5
+	EOF
+	cat >expect <<-\EOF &&
+	refs/heads/commit-1-1
+	refs/heads/commit-3-5
+	refs/heads/commit-9-2
+	EOF
+	run_all_modes git for-each-ref \
+		--no-contains=commit-5-3 \
+		--no-contains=commit-3-6 \
+		--format="%(refname)" \
+		--stdin
+'
+
 test_done
@@ -313,4 +313,41 @@ test_expect_success 'status ignores submodule in excluded directory' '
 	test_cmp expected actual
 '
 
+test_expect_success 'threaded untracked scan finds the same paths' '
+	git init scan &&
+	(
+		cd scan &&
+		mkdir -p a/deep b c/sub d &&
+		for d in a b c d
+		do
+			echo $d >$d/tracked || return 1
+		done &&
+		echo "*.o" >a/.gitignore &&
+		echo sub/ >c/.gitignore &&
+		git add . &&
+		git commit -m tracked &&
+		>a/file.o &&
+		>a/deep/file.o &&
+		>a/deep/new &&
+		>b/file.o &&
+		>b/new &&
+		>c/sub/new &&
+		>c/new &&
+		git init d/nested &&
+		test_commit -C d/nested initial &&
+		for args in "--ignored -uall" "--ignored=matching -unormal" -unormal
+		do
+			GIT_TEST_DIR_SCAN_THREADS=1 \
+				git status --porcelain $args >../expect &&
+			GIT_TRACE2_PERF="$(pwd)/../trace" GIT_TEST_DIR_SCAN_THREADS=3 \
+				git status --porcelain $args >../actual &&
+			test_cmp ../expect ../actual || return 1
+		done &&
+		GIT_TEST_DIR_SCAN_THREADS=1 git clean -n -d -x >../expect &&
+		GIT_TEST_DIR_SCAN_THREADS=3 git clean -n -d -x >../actual &&
+		test_cmp ../expect ../actual
+	) &&
+	grep "read_directo.*scan-threads:3" trace
+'
+
 test_done
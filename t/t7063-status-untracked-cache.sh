@@ -61,12 +61,13 @@ get_relevant_traces () {
 	# From the GIT_TRACE2_PERF data of the form
 	#    $TIME $FILE:$LINE | d0 | main | data | r1 | ? | ? | read_directo | $RELEVANT_STAT
 	# extract the $RELEVANT_STAT fields.  We don't care about region_enter
-	# or region_leave, or stats for things outside read_directory.
+	# or region_leave, stats for things outside read_directory, or how
+	# many threads scanned the worktree when the cache was bypassed.
 	INPUT_FILE=$1
 	OUTPUT_FILE=$2
 	grep data.*read_directo $INPUT_FILE |
 	    cut -d "|" -f 9 |
-	    grep -v visited \
+	    grep -v -e visited -e scan-threads \
 	    >"$OUTPUT_FILE"
 }
 
@@ -130,6 +130,88 @@ test_expect_success '--exclude-promisor-objects does not BUG-crash' '
 	test_must_fail git blame --exclude-promisor-objects one
 '
 
+test_expect_success 'blame.cache gives the same result' '
+	test_when_finished "rm -rf .git/blame-cache" &&
+	git blame --porcelain main^ -- file >expect.parent &&
+	git blame --porcelain main -- file >expect &&
+	git -c blame.cache=true blame --porcelain main^ -- file >actual &&
+	test_cmp expect.parent actual &&
+	GIT_TRACE2_PERF="$(pwd)/trace.txt" \
+		git -c blame.cache=true blame --porcelain main -- file >actual &&
+	test_cmp expect actual &&
+	grep "cache/hits:1" trace.txt &&
+	rm trace.txt &&
+	GIT_TRACE2_PERF="$(pwd)/trace.txt" \
+		git -c blame.cache=true blame --porcelain main -- file >actual &&
+	test_cmp expect actual &&
+	grep "cache/hits:1" trace.txt &&
+	grep "cache/misses:0" trace.txt
+'
+
+test_expect_success 'blame.cache does not survive unshallowing' '
+	test_when_finished "rm -rf shallow-src shallow" &&
+	git init shallow-src &&
+	for i in 1 2 3 4
+	do
+		echo line$i >>shallow-src/f &&
+		git -C shallow-src add f &&
+		git -C shallow-src commit -m "commit $i" || return 1
+	done &&
+	git clone --depth 2 "file://$(pwd)/shallow-src" shallow &&
+	git -C shallow -c blame.cache=true blame -s HEAD -- f &&
+	git -C shallow fetch --unshallow &&
+	git -C shallow blame -s HEAD -- f >expect &&
+	git -C shallow -c blame.cache=true blame -s HEAD -- f >actual &&
+	test_cmp expect actual
+'
+
+test_expect_success 'gc prunes unused blame.cache entries' '
+	test_when_finished "rm -rf .git/blame-cache" &&
+	git -c blame.cache=true blame main -- file >/dev/null &&
+	find .git/blame-cache -type f >tip &&
+	test_line_count = 1 tip &&
+	test-tool chmtime =-5000000 $(cat tip) &&
+	git -c blame.cache=true blame main^ -- file >/dev/null &&
+	find .git/blame-cache -type f | sort >all &&
+	test_line_count = 2 all &&
+	comm -13 tip all >parent &&
+	git gc --quiet &&
+	find .git/blame-cache -type f >actual &&
+	test_cmp parent actual &&
+
+	# a cache hit keeps an old entry alive
+	test-tool chmtime =-5000000 $(cat parent) &&
+	git -c blame.cache=true blame main -- file >/dev/null &&
+	git gc --quiet &&
+	find .git/blame-cache -type f | sort >actual &&
+	test_cmp all actual &&
+
+	git -c gc.blameCacheExpire=now gc --quiet &&
+	test_path_is_missing .git/blame-cache/*
+'
+
+test_expect_success 'blame.cache is not used with -C' '
+	test_when_finished "rm -rf .git/blame-cache" &&
+	git -c blame.cache=true blame -C main -- file >/dev/null &&
+	test_path_is_missing .git/blame-cache
+'
+
+test_expect_success 'blame.threads gives the same result' '
+	git blame --porcelain main -- file >expect &&
+	git -c blame.threads=3 blame --porcelain main -- file >actual &&
+	test_cmp expect actual &&
+	git blame -M -w --porcelain main -- file >expect &&
+	git -c blame.threads=3 blame -M -w --porcelain main -- file >actual &&
+	test_cmp expect actual
+'
+
+test_expect_success PTHREADS 'blame.threads computes diffs on worker threads' '
+	GIT_TRACE2_PERF="$(pwd)/trace.txt" \
+		git -c blame.threads=3 blame main -- file >/dev/null &&
+	grep "prefetch/diffs-used" trace.txt &&
+	rm trace.txt
+'
+
 test_expect_success 'blame with uncommitted edits in partial clone does not crash' '
 	git init server &&
 	echo foo >server/file.txt &&
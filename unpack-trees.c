@@ -7,6 +7,7 @@
 #include "environment.h"
 #include "gettext.h"
 #include "hex.h"
+#include "mem-pool.h"
 #include "name-hash.h"
 #include "tree.h"
 #include "tree-walk.h"
@@ -1861,6 +1862,42 @@ static void update_sparsity_for_prefix(const char *prefix,
 static int verify_absent(const struct cache_entry *,
 			 enum unpack_trees_error_types,
 			 struct unpack_trees_options *);
+/*
+ * The result usually ends up with about as many entries as the source
+ * index. Size its entry array and the memory pool its entries are
+ * allocated from for that up front, instead of growing them one entry
+ * and one block at a time while the trees are merged.
+ */
+static void presize_result_index(struct unpack_trees_options *o)
+{
+	struct index_state *result = &o->internal.result;
+
+	if (result->cache_alloc < o->src_index->cache_nr) {
+		result->cache_alloc = o->src_index->cache_nr;
+		REALLOC_ARRAY(result->cache, result->cache_alloc);
+	}
+	if (result->split_index || !o->src_index->ce_mem_pool)
+		return;
+	result->ce_mem_pool = xmalloc(sizeof(*result->ce_mem_pool));
+	mem_pool_init(result->ce_mem_pool, o->src_index->ce_mem_pool->pool_alloc);
+}
+
+static void trace_result_pool(struct repository *r,
+			      struct index_state *result)
+{
+	struct mp_block *block;
+	intmax_t nr_blocks = 0;
+
+	if (!result->ce_mem_pool || !trace2_is_enabled())
+		return;
+	for (block = result->ce_mem_pool->mp_block; block; block = block->next_block)
+		nr_blocks++;
+	trace2_data_intmax("unpack_trees", r,
+			   "result/pool_blocks", nr_blocks);
+	trace2_data_intmax("unpack_trees", r,
+			   "result/pool_bytes", result->ce_mem_pool->pool_alloc);
+}
+
 /*
  * N-way merge "len" trees.  Returns 0 on success, -1 on failure to manipulate the
  * resulting index, -2 on failure to reflect the changes to the work tree.
@@ -1942,6 +1979,7 @@ int unpack_trees(unsigned len, struct tree_desc *t, struct unpack_trees_options
 			init_split_index(&o->internal.result);
 	}
 	oidcpy(&o->internal.result.oid, &o->src_index->oid);
+	presize_result_index(o);
 	o->internal.merge_size = len;
 	mark_all_ce_unused(o->src_index);
 
@@ -2073,6 +2111,7 @@ int unpack_trees(unsigned len, struct tree_desc *t, struct unpack_trees_options
 		}
 
 		o->internal.result.updated_workdir = 1;
+		trace_result_pool(o->src_index->repo, &o->internal.result);
 		discard_index(o->dst_index);
 		*o->dst_index = o->internal.result;
 	} else {